@@ -377,6 +377,9 @@ void player_wipe(void)
         l_ptr->pkills = 0;
     }
 
+    /* The racial limits have changed */
+    alloc_race_stamp++;
+
     /*No current player ghosts*/
     bones_selector = 0;
 
@@ -385,6 +388,7 @@ void player_wipe(void)
 
     // reset the stair info
     p_ptr->stairs_taken = 0;
+    p_ptr->levels_generated = 0;
     p_ptr->staircasiness = 0;
 
     // reset the forge info
@@ -1253,179 +1253,28 @@ int player_tile_offset()
     return 0;
 }
 
-
 /*
- * Extract the attr/char to display at the given (legal) map location
- *
- * Note that this function, since it is called by "lite_spot()" which
- * is called by "update_view()", is a major efficiency concern.
- *
- * Basically, we examine each "layer" of the world (terrain, objects,
- * monsters/players), from the bottom up, extracting a new attr/char
- * if necessary at each layer, and defaulting to "darkness".  This is
- * not the fastest method, but it is very simple, and it is about as
- * fast as it could be for grids which contain no "marked" objects or
- * "visible" monsters.
- *
- * We apply the effects of hallucination during each layer.  Objects will
- * always appear as random "objects", monsters will always appear as random
- * "monsters", and normal grids occasionally appear as random "monsters" or
- * "objects", but note that these random "monsters" and "objects" are really
- * just "colored ascii symbols" (which may look silly on some machines).
- *
- * The hallucination functions avoid taking any pointers to local variables
- * because some compilers refuse to use registers for any local variables
- * whose address is taken anywhere in the function.
- *
- * As an optimization, we can handle the "player" grid as a special case.
- *
- * Note that the memorization of "objects" and "monsters" is not related
- * to the memorization of "terrain".  This allows the player to memorize
- * the terrain of a grid without memorizing any objects in that grid, and
- * to detect monsters without detecting anything about the terrain of the
- * grid containing the monster.
- *
- * The fact that all interesting "objects" and "terrain features" are
- * memorized as soon as they become visible for the first time means
- * that we only have to check the "CAVE_SEEN" flag for "boring" grids.
- *
- * Note that bizarre things must be done when the "attr" and/or "char"
- * codes have the "high-bit" set, since these values are used to encode
- * various "special" pictures in some versions, and certain situations,
- * such as "multi-hued" or "clear" monsters, cause the attr/char codes
- * to be "scrambled" in various ways.
- *
- * Note that the "zero" entry in the feature/object/monster arrays are
- * used to provide "special" attr/char codes, with "monster zero" being
- * used for the player attr/char, "object zero" being used for the "pile"
- * attr/char, and "feature zero" being used for the "darkness" attr/char.
- *
- * Note the assumption that doing "x_ptr = &x_info[x]" plus a few of
- * "x_ptr->xxx", is quicker than "x_info[x].xxx", even if "x" is a fixed
- * constant.  If this is incorrect then a lot of code should be changed.
- *
- *
- * Some comments on the "terrain" layer...
- *
- * Note that "boring" grids (floors, invisible traps, and any illegal grids)
- * are very different from "interesting" grids (all other terrain features),
- * and the two types of grids are handled completely separately.  The most
- * important distinction is that "boring" grids may or may not be memorized
- * when they are first encountered, and so we must use the "CAVE_SEEN" flag
- * to see if they are "see-able".
- *
- *
- * Some comments on the "terrain" layer (boring grids)...
- *
- * Note that "boring" grids are always drawn using the picture for "empty
- * floors", which is stored in "f_info[FEAT_FLOOR]".  Sometimes, special
- * lighting effects may cause this picture to be modified.
- *
- * Note that "invisible traps" are always displayes exactly like "empty
- * floors", which prevents various forms of "cheating", with no loss of
- * efficiency.  There are still a few ways to "guess" where traps may be
- * located, for example, objects will never fall into a grid containing
- * an invisible trap.  XXX XXX
- *
- * To determine if a "boring" grid should be displayed, we simply check to
- * see if it is either memorized ("CAVE_MARK"), or currently "see-able" by
- * the player ("CAVE_SEEN").  Note that "CAVE_SEEN" is now maintained by the
- * "update_view()" function.
- *
- *
- * Some comments on the "terrain" layer (non-boring grids)...
- *
- * Note the use of the "mimic" field in the "terrain feature" processing,
- * which allows any feature to "pretend" to be another feature.  This is
- * used to "hide" secret doors, and to make all "doors" appear the same,
- * and all "walls" appear the same, and "hidden" treasure stay hidden.
- *
- * Since "interesting" grids are always memorized as soon as they become
- * "see-able" by the player ("CAVE_SEEN"), such a grid only needs to be
- * displayed if it is memorized ("CAVE_MARK").  Most "interesting" grids
- * are in fact non-memorized, non-see-able, wall grids, so the fact that
- * we do not have to check the "CAVE_SEEN" flag adds some efficiency, at
- * the cost of *forcing* the memorization of all "interesting" grids when
- * they are first seen.  Since the "CAVE_SEEN" flag is now maintained by
- * the "update_view()" function, this efficiency is not as significant as
- * it was in previous versions, and could perhaps be removed.
- *
- * Note that "wall" grids are more complicated than "boring" grids, due to
- * the fact that "CAVE_GLOW" for a "wall" grid means that the grid *might*
- * be glowing, depending on where the player is standing in relation to the
- * wall.  In particular, the wall of an illuminated room should look just
- * like any other (dark) wall unless the player is actually inside the room.
- *
- * Thus, we do not support as many visual special effects for "wall" grids
- * as we do for "boring" grids, since many of them would give the player
- * information about the "CAVE_GLOW" flag of the wall grid, in particular,
- * it would allow the player to notice the walls of illuminated rooms from
- * a dark hallway that happened to run beside the room.
- *
- *
- * Some comments on the "object" layer...
- *
- * Currently, we do nothing with multi-hued objects, because there are
- * not any.  If there were, they would have to set "shimmer_objects"
- * when they were created, and then new "shimmer" code in "dungeon.c"
- * would have to be created handle the "shimmer" effect, and the code
- * in "cave.c" would have to be updated to create the shimmer effect.
- * This did not seem worth the effort.  XXX XXX
- *
- *
- * Some comments on the "monster"/"player" layer...
+ * Works out how the terrain of a grid looks, for "map_info()".
  *
- * Note that monsters can have some "special" flags, including "ATTR_MULTI",
- * which means their color changes, and "ATTR_CLEAR", which means they take
- * the color of whatever is under them, and "CHAR_CLEAR", which means that
- * they take the symbol of whatever is under them.  Technically, the flag
- * "CHAR_MULTI" is supposed to indicate that a monster looks strange when
- * examined, but this flag is currently ignored.
- *
- * Normally, players could be handled just like monsters, except that the
- * concept of the "torch lite" of others player would add complications.
- * For efficiency, however, we handle the (only) player first, since the
- * "player" symbol always "pre-empts" any other facts about the grid.
- *
- * ToDo: The transformations for tile colors, or brightness for the 16x16
- * tiles should be handled differently.  One possibility would be to
- * extend feature_type with attr/char definitions for the different states.
+ * "featp" is updated to the feature the grid appears to be.  Returns true if
+ * the attr/chars are final and nothing is to be drawn on top of them.
  */
-
-#define GRAF_BROKEN_BONE 440
-
-void map_info(int y, int x, byte* ap, char* cp, byte* tap, char* tcp)
+static bool map_info_terrain(int y, int x, byte* featp, u16b info,
+    bool hide_square, bool rage_active, byte* ap, char* cp, byte* tap,
+    char* tcp)
 {
-    byte a = TERM_DARK; // these are defaults to soothe compilation warnings
-    char c = ' '; //
+    byte a = TERM_DARK;
+    char c = ' ';
 
-    byte feat;
-    u16b info;
+    byte feat = *featp;
 
     feature_type* f_ptr;
-    object_type* o_ptr;
-
-    s16b m_idx;
-
-    s16b image = p_ptr->image;
 
-    /* Monster/Player */
-    m_idx = cave_m_idx[y][x];
-
-    /* Feature */
-    feat = cave_feat[y][x];
-
-    /* Cave flags */
-    info = cave_info[y][x];
-
-    bool hide_square = false;
-    bool rage_active = false;
-
-    // 'rage' effects...
-    if ((!p_ptr->is_dead) && p_ptr->rage && !(info & (CAVE_SEEN)))
-        hide_square = true;
-    if ((!p_ptr->is_dead) && p_ptr->rage)
-        rage_active = true;
+    /* Default to darkness */
+    *ap = a;
+    *cp = c;
+    *tap = a;
+    *tcp = c;
 
     /* make sure not to display things off screen */
     if ((y < 0) || (x < 0) || (y >= p_ptr->cur_map_hgt)
@@ -1562,7 +1411,7 @@ void map_info(int y, int x, byte* ap, char* cp, byte* tap, char* tcp)
                                 }
                             }
                             *ap = a; *cp = c;
-                            return;
+                            return (true);
                         }
                     } else {
                         /* No encoded style in cave_color: fall back to primary style (level or vault). */
@@ -1584,11 +1433,11 @@ void map_info(int y, int x, byte* ap, char* cp, byte* tap, char* tcp)
                             *ap = a; *cp = c; /* overlay vein */
                             *tap = wall_a; *tcp = wall_c; /* base wall */
                             log_warn("VEIN fallback: unencoded cave_color=%d at (%d,%d); using primary style %d wall(row=%d,col=%d)", color_value, y, x, fb, sfb->wall_row, sfb->wall_col);
-                            return;
+                            return (true);
                         } else {
                             /* Give up: leave existing tiles */
                             log_warn("VEIN fallback: no primary style available at (%d,%d)", y, x);
-                            return;
+                            return (true);
                         }
                     }
                 } else {
@@ -1612,47 +1461,340 @@ void map_info(int y, int x, byte* ap, char* cp, byte* tap, char* tcp)
                     }
                 }
 
-                /* Apply standard lighting effects (+1 for dark version)
-                 * Dark variant only if not sunlit (no CAVE_GLOW) or if blind. */
-                if (use_graphics == GRAPHICS_MICROCHASM && feat_supports_lighting(feat)) {
-                    if (p_ptr->blind || (!(info & (CAVE_GLOW)) && cave_light[y][x] <= 0)) {
-                        c += 1;
-                    }
-                }
+                /* Apply standard lighting effects (+1 for dark version)
+                 * Dark variant only if not sunlit (no CAVE_GLOW) or if blind. */
+                if (use_graphics == GRAPHICS_MICROCHASM && feat_supports_lighting(feat)) {
+                    if (p_ptr->blind || (!(info & (CAVE_GLOW)) && cave_light[y][x] <= 0)) {
+                        c += 1;
+                    }
+                }
+
+                /* Apply the updated tile coordinates to both main and terrain */
+                *ap = a;
+                *cp = c;
+                *tap = a;
+                *tcp = c;
+
+                /* Early return since we've set the values */
+                return (true);
+            }
+            else {
+                /* Standard lighting effects for non-wall features */
+                special_lighting_wall(&a, &c, feat, info, cave_light[y][x]);
+            }
+#else
+            /* Depth-based walls disabled, use standard lighting only */
+            special_lighting_wall(&a, &c, feat, info, cave_light[y][x]);
+#endif /* DEPTH_BASED_WALLS */
+        }
+
+        /* Unknown */
+        else
+        {
+            /* Get the darkness feature */
+            f_ptr = &f_info[FEAT_NONE];
+
+            /* Normal attr */
+            a = f_ptr->x_attr;
+
+            /* Normal char */
+            c = f_ptr->x_char;
+        }
+    }
+
+    *featp = feat;
+
+    (*ap) = a;
+    (*cp) = c;
+    (*tap) = a;
+    (*tcp) = c;
+
+    return (false);
+}
+
+/*
+ * The terrain of each grid as last worked out by "map_info()", along with
+ * everything that went into it.  Most grids look the same from one redraw to
+ * the next, so they can be answered from here rather than worked out afresh.
+ *
+ * Monsters and objects are always drawn on top afresh, since they move about
+ * and may change colour from turn to turn.
+ */
+typedef struct map_memo map_memo;
+
+struct map_memo
+{
+    u16b stamp; /* map_memo_stamp when this was filled in */
+    u16b mode; /* Player and option state (see map_memo_mode()) */
+    u16b info; /* cave_info */
+    s16b light; /* cave_light */
+    byte feat; /* cave_feat */
+    byte color; /* cave_color */
+
+    byte shown_feat; /* The feature the grid appears to be */
+    bool final; /* Nothing is drawn on top */
+    byte a;
+    char c;
+    byte ta;
+    char tc;
+};
+
+static map_memo map_memo_grid[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+
+static u16b map_memo_stamp = 1;
+
+/*
+ * Forget the remembered terrain of every grid.
+ *
+ * This is needed whenever the terrain might look different for some reason
+ * other than the grid itself changing, such as a new level (with new styles)
+ * or new visual preferences.
+ */
+void wipe_map_memo(void)
+{
+    map_memo_stamp++;
+
+    /* Don't let old entries come back to life when the stamp wraps */
+    if (!map_memo_stamp)
+    {
+        C_WIPE(map_memo_grid, MAX_DUNGEON_HGT, map_memo[MAX_DUNGEON_WID]);
+        map_memo_stamp = 1;
+    }
+}
+
+/*
+ * The parts of the player and option state that affect how terrain looks
+ */
+static u16b map_memo_mode(bool rage_active)
+{
+    u16b mode = (u16b)(use_graphics & 0x0F);
+
+    if (p_ptr->blind)
+        mode |= 0x0010;
+    if (rage_active)
+        mode |= 0x0020;
+    if (use_background_colors)
+        mode |= 0x0040;
+    if (hybrid_walls)
+        mode |= 0x0080;
+    if (solid_walls)
+        mode |= 0x0100;
+    if (g_vault_primary_style >= 0)
+        mode |= 0x0200;
+
+    return (mode);
+}
+
+/*
+ * Extract the attr/char to display at the given (legal) map location
+ *
+ * Note that this function, since it is called by "lite_spot()" which
+ * is called by "update_view()", is a major efficiency concern.
+ *
+ * Basically, we examine each "layer" of the world (terrain, objects,
+ * monsters/players), from the bottom up, extracting a new attr/char
+ * if necessary at each layer, and defaulting to "darkness".  This is
+ * not the fastest method, but it is very simple, and it is about as
+ * fast as it could be for grids which contain no "marked" objects or
+ * "visible" monsters.
+ *
+ * We apply the effects of hallucination during each layer.  Objects will
+ * always appear as random "objects", monsters will always appear as random
+ * "monsters", and normal grids occasionally appear as random "monsters" or
+ * "objects", but note that these random "monsters" and "objects" are really
+ * just "colored ascii symbols" (which may look silly on some machines).
+ *
+ * The hallucination functions avoid taking any pointers to local variables
+ * because some compilers refuse to use registers for any local variables
+ * whose address is taken anywhere in the function.
+ *
+ * As an optimization, we can handle the "player" grid as a special case.
+ *
+ * Note that the memorization of "objects" and "monsters" is not related
+ * to the memorization of "terrain".  This allows the player to memorize
+ * the terrain of a grid without memorizing any objects in that grid, and
+ * to detect monsters without detecting anything about the terrain of the
+ * grid containing the monster.
+ *
+ * The fact that all interesting "objects" and "terrain features" are
+ * memorized as soon as they become visible for the first time means
+ * that we only have to check the "CAVE_SEEN" flag for "boring" grids.
+ *
+ * Note that bizarre things must be done when the "attr" and/or "char"
+ * codes have the "high-bit" set, since these values are used to encode
+ * various "special" pictures in some versions, and certain situations,
+ * such as "multi-hued" or "clear" monsters, cause the attr/char codes
+ * to be "scrambled" in various ways.
+ *
+ * Note that the "zero" entry in the feature/object/monster arrays are
+ * used to provide "special" attr/char codes, with "monster zero" being
+ * used for the player attr/char, "object zero" being used for the "pile"
+ * attr/char, and "feature zero" being used for the "darkness" attr/char.
+ *
+ * Note the assumption that doing "x_ptr = &x_info[x]" plus a few of
+ * "x_ptr->xxx", is quicker than "x_info[x].xxx", even if "x" is a fixed
+ * constant.  If this is incorrect then a lot of code should be changed.
+ *
+ *
+ * Some comments on the "terrain" layer...
+ *
+ * Note that "boring" grids (floors, invisible traps, and any illegal grids)
+ * are very different from "interesting" grids (all other terrain features),
+ * and the two types of grids are handled completely separately.  The most
+ * important distinction is that "boring" grids may or may not be memorized
+ * when they are first encountered, and so we must use the "CAVE_SEEN" flag
+ * to see if they are "see-able".
+ *
+ *
+ * Some comments on the "terrain" layer (boring grids)...
+ *
+ * Note that "boring" grids are always drawn using the picture for "empty
+ * floors", which is stored in "f_info[FEAT_FLOOR]".  Sometimes, special
+ * lighting effects may cause this picture to be modified.
+ *
+ * Note that "invisible traps" are always displayes exactly like "empty
+ * floors", which prevents various forms of "cheating", with no loss of
+ * efficiency.  There are still a few ways to "guess" where traps may be
+ * located, for example, objects will never fall into a grid containing
+ * an invisible trap.  XXX XXX
+ *
+ * To determine if a "boring" grid should be displayed, we simply check to
+ * see if it is either memorized ("CAVE_MARK"), or currently "see-able" by
+ * the player ("CAVE_SEEN").  Note that "CAVE_SEEN" is now maintained by the
+ * "update_view()" function.
+ *
+ *
+ * Some comments on the "terrain" layer (non-boring grids)...
+ *
+ * Note the use of the "mimic" field in the "terrain feature" processing,
+ * which allows any feature to "pretend" to be another feature.  This is
+ * used to "hide" secret doors, and to make all "doors" appear the same,
+ * and all "walls" appear the same, and "hidden" treasure stay hidden.
+ *
+ * Since "interesting" grids are always memorized as soon as they become
+ * "see-able" by the player ("CAVE_SEEN"), such a grid only needs to be
+ * displayed if it is memorized ("CAVE_MARK").  Most "interesting" grids
+ * are in fact non-memorized, non-see-able, wall grids, so the fact that
+ * we do not have to check the "CAVE_SEEN" flag adds some efficiency, at
+ * the cost of *forcing* the memorization of all "interesting" grids when
+ * they are first seen.  Since the "CAVE_SEEN" flag is now maintained by
+ * the "update_view()" function, this efficiency is not as significant as
+ * it was in previous versions, and could perhaps be removed.
+ *
+ * Note that "wall" grids are more complicated than "boring" grids, due to
+ * the fact that "CAVE_GLOW" for a "wall" grid means that the grid *might*
+ * be glowing, depending on where the player is standing in relation to the
+ * wall.  In particular, the wall of an illuminated room should look just
+ * like any other (dark) wall unless the player is actually inside the room.
+ *
+ * Thus, we do not support as many visual special effects for "wall" grids
+ * as we do for "boring" grids, since many of them would give the player
+ * information about the "CAVE_GLOW" flag of the wall grid, in particular,
+ * it would allow the player to notice the walls of illuminated rooms from
+ * a dark hallway that happened to run beside the room.
+ *
+ *
+ * Some comments on the "object" layer...
+ *
+ * Currently, we do nothing with multi-hued objects, because there are
+ * not any.  If there were, they would have to set "shimmer_objects"
+ * when they were created, and then new "shimmer" code in "dungeon.c"
+ * would have to be created handle the "shimmer" effect, and the code
+ * in "cave.c" would have to be updated to create the shimmer effect.
+ * This did not seem worth the effort.  XXX XXX
+ *
+ *
+ * Some comments on the "monster"/"player" layer...
+ *
+ * Note that monsters can have some "special" flags, including "ATTR_MULTI",
+ * which means their color changes, and "ATTR_CLEAR", which means they take
+ * the color of whatever is under them, and "CHAR_CLEAR", which means that
+ * they take the symbol of whatever is under them.  Technically, the flag
+ * "CHAR_MULTI" is supposed to indicate that a monster looks strange when
+ * examined, but this flag is currently ignored.
+ *
+ * Normally, players could be handled just like monsters, except that the
+ * concept of the "torch lite" of others player would add complications.
+ * For efficiency, however, we handle the (only) player first, since the
+ * "player" symbol always "pre-empts" any other facts about the grid.
+ *
+ * ToDo: The transformations for tile colors, or brightness for the 16x16
+ * tiles should be handled differently.  One possibility would be to
+ * extend feature_type with attr/char definitions for the different states.
+ */
+
+#define GRAF_BROKEN_BONE 440
 
-                /* Apply the updated tile coordinates to both main and terrain */
-                *ap = a;
-                *cp = c;
-                *tap = a;
-                *tcp = c;
+void map_info(int y, int x, byte* ap, char* cp, byte* tap, char* tcp)
+{
+    byte a = TERM_DARK; // these are defaults to soothe compilation warnings
+    char c = ' '; //
 
-                /* Early return since we've set the values */
-                return;
-            }
-            else {
-                /* Standard lighting effects for non-wall features */
-                special_lighting_wall(&a, &c, feat, info, cave_light[y][x]);
-            }
-#else
-            /* Depth-based walls disabled, use standard lighting only */
-            special_lighting_wall(&a, &c, feat, info, cave_light[y][x]);
-#endif /* DEPTH_BASED_WALLS */
-        }
+    byte feat;
+    u16b info;
 
-        /* Unknown */
-        else
-        {
-            /* Get the darkness feature */
-            f_ptr = &f_info[FEAT_NONE];
+    object_type* o_ptr;
 
-            /* Normal attr */
-            a = f_ptr->x_attr;
+    s16b m_idx;
 
-            /* Normal char */
-            c = f_ptr->x_char;
-        }
+    map_memo* memo;
+    u16b mode;
+
+    s16b image = p_ptr->image;
+
+    /* Monster/Player */
+    m_idx = cave_m_idx[y][x];
+
+    /* Feature */
+    feat = cave_feat[y][x];
+
+    /* Cave flags */
+    info = cave_info[y][x];
+
+    bool hide_square = false;
+    bool rage_active = false;
+
+    // 'rage' effects...
+    if ((!p_ptr->is_dead) && p_ptr->rage && !(info & (CAVE_SEEN)))
+        hide_square = true;
+    if ((!p_ptr->is_dead) && p_ptr->rage)
+        rage_active = true;
+
+    /* Look up the terrain, working it out again only if something changed */
+    memo = &map_memo_grid[y][x];
+    mode = map_memo_mode(rage_active);
+
+    if ((memo->stamp != map_memo_stamp) || (memo->mode != mode)
+        || (memo->info != info) || (memo->light != cave_light[y][x])
+        || (memo->feat != feat) || (memo->color != cave_color[y][x]))
+    {
+        memo->stamp = map_memo_stamp;
+        memo->mode = mode;
+        memo->info = info;
+        memo->light = cave_light[y][x];
+        memo->feat = feat;
+        memo->color = cave_color[y][x];
+
+        memo->shown_feat = feat;
+        memo->final = map_info_terrain(y, x, &memo->shown_feat, info,
+            hide_square, rage_active, &memo->a, &memo->c, &memo->ta,
+            &memo->tc);
+    }
+
+    /* Some terrain is never drawn over */
+    if (memo->final)
+    {
+        (*ap) = memo->a;
+        (*cp) = memo->c;
+        (*tap) = memo->ta;
+        (*tcp) = memo->tc;
+        return;
     }
 
+    feat = memo->shown_feat;
+    a = memo->a;
+    c = memo->c;
+
     /* Save the terrain info for the transparency effects */
     (*tap) = a;
     (*tcp) = c;
@@ -2289,6 +2431,45 @@ void note_spot(int y, int x)
             cave_info[y][x] |= (CAVE_MARK);
         }
     }
+
+    /* The memory of the grid may have changed */
+    queue_spot(y, x);
+}
+
+/*
+ * The small-scale map shown by "display_map()", kept from one showing to the
+ * next.  Each cell remembers the attr/char and priority of the grid that won
+ * it, so only the cells holding grids that have changed since need to be
+ * worked out again.
+ *
+ * Grids are noted as changed by "lite_spot()" and "queue_spot()", even when
+ * off the panel, and the whole map is marked stale by "prt_map()", which is
+ * what happens on a new level or when the visuals change.
+ */
+static byte overview_a[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+static char overview_c[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+static byte overview_p[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+
+static bool overview_queued[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+static u16b overview_queue[MAX_DUNGEON_HGT * MAX_DUNGEON_WID];
+static int overview_queue_n = 0;
+
+/* The shape the overview was last built for */
+static bool overview_stale = true;
+static int overview_hgt, overview_wid;
+static int overview_map_hgt, overview_map_wid;
+static bool overview_bigtile;
+
+/*
+ * Note that a grid may look different on the small-scale map
+ */
+static void note_overview(int y, int x)
+{
+    if (overview_stale || overview_queued[y][x])
+        return;
+
+    overview_queued[y][x] = true;
+    overview_queue[overview_queue_n++] = GRID(y, x);
 }
 
 /*
@@ -2310,6 +2491,9 @@ void lite_spot(int y, int x)
     int ky, kx;
     int vy, vx;
 
+    /* The small-scale map may need to change too */
+    note_overview(y, x);
+
     /* Location relative to panel */
     ky = y - p_ptr->wy;
 
@@ -2351,6 +2535,88 @@ void lite_spot(int y, int x)
     }
 }
 
+/*
+ * Grids whose appearance has changed since the map was last drawn.
+ *
+ * spot_queued marks the grids already in the list so that each is drawn
+ * only once however often it changes between redraws.
+ */
+static bool spot_queued[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+static u16b spot_queue[MAX_DUNGEON_HGT * MAX_DUNGEON_WID];
+static int spot_queue_n = 0;
+
+/*
+ * Forget the queued grids (the whole map is about to be drawn)
+ */
+static void forget_spots(void)
+{
+    int i;
+
+    for (i = 0; i < spot_queue_n; i++)
+    {
+        spot_queued[GRID_Y(spot_queue[i])][GRID_X(spot_queue[i])] = false;
+    }
+
+    spot_queue_n = 0;
+}
+
+/*
+ * Queue a grid to be redrawn at the next redraw of the changed grids.
+ *
+ * Unlike "lite_spot()" this does no work until the grid is drawn, so it is
+ * the one to use when the same grid may change several times before the
+ * player gets to see it.  Grids outside the panel are ignored, since moving
+ * the panel redraws the whole map anyway.
+ */
+void queue_spot(int y, int x)
+{
+    /* The small-scale map may need to change too */
+    note_overview(y, x);
+
+    /* Only grids on the panel are ever drawn */
+    if (!panel_contains(y, x))
+        return;
+
+    /* Note that there is something to draw */
+    p_ptr->redraw |= (PR_SPOTS);
+
+    /* Already queued */
+    if (spot_queued[y][x])
+        return;
+
+    spot_queued[y][x] = true;
+    spot_queue[spot_queue_n++] = GRID(y, x);
+}
+
+/*
+ * Redraw (on the screen) the grids queued by "queue_spot()"
+ *
+ * The grids are left queued while the map is hidden by another screen, so
+ * that they are still drawn once it comes back.
+ */
+void prt_spots(void)
+{
+    int i;
+
+    /* Nothing to draw on */
+    if (character_icky)
+        return;
+
+    for (i = 0; i < spot_queue_n; i++)
+    {
+        int y = GRID_Y(spot_queue[i]);
+        int x = GRID_X(spot_queue[i]);
+
+        spot_queued[y][x] = false;
+
+        lite_spot(y, x);
+    }
+
+    spot_queue_n = 0;
+
+    p_ptr->redraw &= ~(PR_SPOTS);
+}
+
 /*
  * Redraw (on the screen) the current map panel
  *
@@ -2369,6 +2635,13 @@ void prt_map(void)
     int vy, vx;
     int ty, tx;
 
+    /* Every queued grid is about to be drawn anyway */
+    forget_spots();
+    p_ptr->redraw &= ~(PR_SPOTS);
+
+    /* Anything may have changed, so the small-scale map must be rebuilt */
+    overview_stale = true;
+
     /* Assume screen */
     ty = p_ptr->wy + SCREEN_HGT;
     tx = p_ptr->wx + SCREEN_WID;
@@ -2414,61 +2687,225 @@ static const int priority_table[13][2] = {
     /* Floors */
     { FEAT_FLOOR, 5 },
 
-    /* Walls */
-    { FEAT_SECRET, 10 },
+    /* Walls */
+    { FEAT_SECRET, 10 },
+
+    /* Quartz */
+    { FEAT_QUARTZ, 11 },
+
+    /* Rubble */
+    { FEAT_RUBBLE, 13 },
+
+    /* Open doors */
+    { FEAT_OPEN, 15 }, { FEAT_BROKEN, 15 },
+
+    /* Closed doors */
+    { FEAT_DOOR_HEAD + 0x00, 17 },
+
+    /* Stairs */
+    { FEAT_LESS, 25 }, { FEAT_MORE, 25 }, { FEAT_LESS_SHAFT, 25 },
+    { FEAT_MORE_SHAFT, 25 },
+
+    /* End */
+    { 0, 0 }
+};
+
+/*
+ * Hack -- a priority function (see below)
+ */
+static byte priority(byte a, char c)
+{
+    int i, p0, p1;
+
+    feature_type* f_ptr;
+
+    /* Scan the table */
+    for (i = 0; true; i++)
+    {
+        /* Priority level */
+        p1 = priority_table[i][1];
+
+        /* End of table */
+        if (!p1)
+            break;
+
+        /* Feature index */
+        p0 = priority_table[i][0];
+
+        /* Get the feature */
+        f_ptr = &f_info[p0];
+
+        /* Check character and attribute, accept matches */
+        if ((f_ptr->x_char == c) && (f_ptr->x_attr == a))
+            return (p1);
+    }
+
+    /* Default */
+    return (20);
+}
+
+/*
+ * Works out how a grid looks on the small-scale map, and how much it matters
+ */
+static byte overview_grid(int y, int x, byte* ap, char* cp)
+{
+    byte tp;
+
+    byte ta;
+    char tc;
+
+    /* Get the attr/char at that map location */
+    map_info(y, x, ap, cp, &ta, &tc);
+
+    /* Get the priority of that attr/char */
+    tp = priority(*ap, *cp);
+
+    /* Examine boring grids */
+    if ((tp == 20) && (cave_m_idx[y][x] > 0))
+    {
+        monster_type* m_ptr = &mon_list[cave_m_idx[y][x]];
+        monster_race* r_ptr = &r_info[m_ptr->r_idx];
+
+        /* Notice dangerous monsters */
+        /* Sil-y: this may need some tweaking */
+        tp = MAX(20, (int)r_ptr->level - p_ptr->depth + 20);
+
+        /* Ignore invisible monsters */
+        if (!m_ptr->ml)
+            tp = 20;
+    }
+
+    return (tp);
+}
+
+/*
+ * Offers a grid for a cell of the small-scale map, which shows the first of
+ * its grids with the highest priority
+ */
+static void overview_offer(int y, int x)
+{
+    int row = (y * overview_hgt / p_ptr->cur_map_hgt);
+    int col = (x * overview_wid / p_ptr->cur_map_wid);
+
+    byte ta;
+    char tc;
+    byte tp;
+
+    if (overview_bigtile)
+        col = col & ~1;
+
+    tp = overview_grid(y, x, &ta, &tc);
+
+    /* Save "best" */
+    if (overview_p[row][col] < tp)
+    {
+        overview_a[row][col] = ta;
+        overview_c[row][col] = tc;
+        overview_p[row][col] = tp;
+    }
+}
+
+/*
+ * Works out the cell of the small-scale map holding a changed grid again
+ */
+static void overview_refresh_cell(int gy, int gx)
+{
+    int row = (gy * overview_hgt / p_ptr->cur_map_hgt);
+    int col = (gx * overview_wid / p_ptr->cur_map_wid);
+    int last_col;
 
-    /* Quartz */
-    { FEAT_QUARTZ, 11 },
+    int y, x;
+    int y1, y2, x1, x2;
 
-    /* Rubble */
-    { FEAT_RUBBLE, 13 },
+    if (overview_bigtile)
+        col = col & ~1;
 
-    /* Open doors */
-    { FEAT_OPEN, 15 }, { FEAT_BROKEN, 15 },
+    last_col = (overview_bigtile) ? (col + 1) : col;
 
-    /* Closed doors */
-    { FEAT_DOOR_HEAD + 0x00, 17 },
+    /* The grids that share the cell (the first grid of each one onwards) */
+    y1 = (row * p_ptr->cur_map_hgt + overview_hgt - 1) / overview_hgt;
+    y2 = ((row + 1) * p_ptr->cur_map_hgt + overview_hgt - 1) / overview_hgt;
+    x1 = (col * p_ptr->cur_map_wid + overview_wid - 1) / overview_wid;
+    x2 = ((last_col + 1) * p_ptr->cur_map_wid + overview_wid - 1)
+        / overview_wid;
 
-    /* Stairs */
-    { FEAT_LESS, 25 }, { FEAT_MORE, 25 }, { FEAT_LESS_SHAFT, 25 },
-    { FEAT_MORE_SHAFT, 25 },
+    if (y2 > p_ptr->cur_map_hgt)
+        y2 = p_ptr->cur_map_hgt;
+    if (x2 > p_ptr->cur_map_wid)
+        x2 = p_ptr->cur_map_wid;
 
-    /* End */
-    { 0, 0 }
-};
+    overview_p[row][col] = 0;
+
+    /* Scan them in the same order as a full rebuild would */
+    for (y = y1; y < y2; y++)
+    {
+        for (x = x1; x < x2; x++)
+        {
+            overview_offer(y, x);
+        }
+    }
+}
 
 /*
- * Hack -- a priority function (see below)
+ * Brings the small-scale map up to date for a map of the given size
  */
-static byte priority(byte a, char c)
+static void update_overview(int map_hgt, int map_wid)
 {
-    int i, p0, p1;
-
-    feature_type* f_ptr;
+    int i;
+    int y, x;
 
-    /* Scan the table */
-    for (i = 0; true; i++)
+    /* A different shape (or anything at all) may have changed */
+    if (overview_stale || (overview_hgt != map_hgt)
+        || (overview_wid != map_wid)
+        || (overview_map_hgt != p_ptr->cur_map_hgt)
+        || (overview_map_wid != p_ptr->cur_map_wid)
+        || (overview_bigtile != use_bigtile))
     {
-        /* Priority level */
-        p1 = priority_table[i][1];
-
-        /* End of table */
-        if (!p1)
-            break;
+        overview_hgt = map_hgt;
+        overview_wid = map_wid;
+        overview_map_hgt = p_ptr->cur_map_hgt;
+        overview_map_wid = p_ptr->cur_map_wid;
+        overview_bigtile = use_bigtile;
+
+        /* Clear the priorities */
+        for (y = 0; y < map_hgt; ++y)
+        {
+            for (x = 0; x < map_wid; ++x)
+            {
+                /* No priority */
+                overview_p[y][x] = 0;
+            }
+        }
 
-        /* Feature index */
-        p0 = priority_table[i][0];
+        /* Analyze the actual map */
+        for (y = 0; y < p_ptr->cur_map_hgt; y++)
+        {
+            for (x = 0; x < p_ptr->cur_map_wid; x++)
+            {
+                overview_offer(y, x);
+            }
+        }
+    }
 
-        /* Get the feature */
-        f_ptr = &f_info[p0];
+    /* Just work out again the cells with changed grids */
+    else
+    {
+        for (i = 0; i < overview_queue_n; i++)
+        {
+            overview_refresh_cell(
+                GRID_Y(overview_queue[i]), GRID_X(overview_queue[i]));
+        }
+    }
 
-        /* Check character and attribute, accept matches */
-        if ((f_ptr->x_char == c) && (f_ptr->x_attr == a))
-            return (p1);
+    /* Forget the changes */
+    for (i = 0; i < overview_queue_n; i++)
+    {
+        overview_queued[GRID_Y(overview_queue[i])][GRID_X(overview_queue[i])]
+            = false;
     }
+    overview_queue_n = 0;
 
-    /* Default */
-    return (20);
+    overview_stale = false;
 }
 
 /*
@@ -2485,6 +2922,9 @@ static byte priority(byte a, char c)
  * the player was displayed, so the cursor can be moved to that location,
  * and restricts the horizontal map size to SCREEN_WID.  Otherwise, nothing
  * is returned (obviously), and no restrictions are enforced.
+ *
+ * The map is kept from one call to the next (see "update_overview()"), so
+ * showing it again only costs as much as the grids that have changed since.
  */
 void display_map(int* cy, int* cx)
 {
@@ -2496,11 +2936,6 @@ void display_map(int* cy, int* cx)
     byte ta;
     char tc;
 
-    byte tp;
-
-    /* Large array on the stack */
-    byte mp[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
-
     monster_race* r_ptr = &r_info[0];
 
     /* Desired map height */
@@ -2521,16 +2956,6 @@ void display_map(int* cy, int* cx)
     ta = TERM_WHITE;
     tc = ' ';
 
-    /* Clear the priorities */
-    for (y = 0; y < map_hgt; ++y)
-    {
-        for (x = 0; x < map_wid; ++x)
-        {
-            /* No priority */
-            mp[y][x] = 0;
-        }
-    }
-
     /* Clear the screen (but don't force a redraw) */
     clear_from(0);
 
@@ -2558,54 +2983,28 @@ void display_map(int* cy, int* cx)
         Term_putch(x, y, ta, '|');
     }
 
-    /* Analyze the actual map */
-    for (y = 0; y < p_ptr->cur_map_hgt; y++)
+    /* Bring the cells up to date */
+    update_overview(map_hgt, map_wid);
+
+    /* Draw them */
+    for (row = 0; row < map_hgt; row++)
     {
-        for (x = 0; x < p_ptr->cur_map_wid; x++)
+        for (col = 0; col < map_wid; col++)
         {
-            row = (y * map_hgt / p_ptr->cur_map_hgt);
-            col = (x * map_wid / p_ptr->cur_map_wid);
-
-            if (use_bigtile)
-                col = col & ~1;
-
-            /* Get the attr/char at that map location */
-            map_info(y, x, &ta, &tc, &ta, &tc);
-
-            /* Get the priority of that attr/char */
-            tp = priority(ta, tc);
-
-            /* Examine boring grids */
-            if ((tp == 20) && (cave_m_idx[y][x] > 0))
-            {
-                monster_type* m_ptr = &mon_list[cave_m_idx[y][x]];
-                monster_race* r_ptr = &r_info[m_ptr->r_idx];
-
-                /* Notice dangerous monsters */
-                /* Sil-y: this may need some tweaking */
-                tp = MAX(20, (int)r_ptr->level - p_ptr->depth + 20);
+            /* Nothing here */
+            if (!overview_p[row][col])
+                continue;
 
-                /* Ignore invisible monsters */
-                if (!m_ptr->ml)
-                    tp = 20;
-            }
+            /* Add the character */
+            Term_putch(
+                col + 1, row + 1, overview_a[row][col], overview_c[row][col]);
 
-            /* Save "best" */
-            if (mp[row][col] < tp)
+            if (use_bigtile)
             {
-                /* Add the character */
-                Term_putch(col + 1, row + 1, ta, tc);
-
-                if (use_bigtile)
-                {
-                    if (ta & 0x80)
-                        Term_putch(col + 2, row + 1, 255, -1);
-                    else
-                        Term_putch(col + 2, row + 1, TERM_WHITE, ' ');
-                }
-
-                /* Save priority */
-                mp[row][col] = tp;
+                if (overview_a[row][col] & 0x80)
+                    Term_putch(col + 2, row + 1, 255, -1);
+                else
+                    Term_putch(col + 2, row + 1, TERM_WHITE, ' ');
             }
         }
     }
@@ -3336,6 +3735,178 @@ bool same_side_of_wall_as_player(int y, int x, int fy, int fx)
     return (same);
 }
 
+/*
+ * Monster light is added to "cave_light" source by source, and what each
+ * monster added is remembered, so that when only monster light has changed
+ * (a torch-bearing orc took a step) "update_light()" can take away the old
+ * contribution and add the new one without relighting the whole level.
+ *
+ * All of this is rebuilt by every call to "update_view()".  Monsters with
+ * unusually large radii, or too many light sources at once, are not
+ * remembered, and then "update_light()" simply calls "update_view()".
+ */
+#define LIGHT_SRC_MAX 64
+#define LIGHT_SRC_RAD 7
+#define LIGHT_SRC_GRIDS ((2 * LIGHT_SRC_RAD + 1) * (2 * LIGHT_SRC_RAD + 1))
+
+typedef struct light_src_type light_src_type;
+
+struct light_src_type
+{
+    s16b m_idx; /* The monster (and its race, when it was lit) */
+    s16b r_idx;
+
+    byte fy; /* Where it was when it was lit */
+    byte fx;
+
+    int n; /* The grids it lit (or darkened), and by how much */
+    u16b grid[LIGHT_SRC_GRIDS];
+    s16b amount[LIGHT_SRC_GRIDS];
+};
+
+static light_src_type light_src[LIGHT_SRC_MAX];
+static int light_src_n = 0;
+
+/*
+ * Some monster light was not remembered, or nothing is remembered yet
+ */
+static bool light_src_lost = true;
+
+/*
+ * Number of light sources brightening each grid, and whether the player's
+ * own view (torch and permanent light) had the grid "CAVE_SEEN"
+ */
+static byte light_cover[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+static bool light_base[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+
+/*
+ * Grids changed by "update_light()", with their light before the change
+ */
+static bool light_touched[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+static u16b light_touch_g[MAX_DUNGEON_HGT * MAX_DUNGEON_WID];
+static s16b light_touch_old[MAX_DUNGEON_HGT * MAX_DUNGEON_WID];
+static int light_touch_n = 0;
+
+/*
+ * Note that the light of a grid is about to change
+ */
+static void light_touch(int y, int x)
+{
+    if (light_touched[y][x])
+        return;
+
+    light_touched[y][x] = true;
+    light_touch_g[light_touch_n] = GRID(y, x);
+    light_touch_old[light_touch_n] = cave_light[y][x];
+    light_touch_n++;
+}
+
+/*
+ * Add the light (or darkness) of a monster to "cave_light", remembering
+ * it if possible.  Only grids in view of the player are affected.
+ */
+static void light_src_add(int m_idx, bool touch)
+{
+    monster_type* m_ptr = &mon_list[m_idx];
+    monster_race* r_ptr = &r_info[m_ptr->r_idx];
+
+    light_src_type* ls = NULL;
+
+
+    int py = p_ptr->py;
+    int px = p_ptr->px;
+
+    int fy = m_ptr->fy;
+    int fx = m_ptr->fx;
+
+    int mon_light = r_ptr->light;
+    int mon_rad = ABS(mon_light);
+
+    bool glow = r_ptr->flags2 & (RF2_GLOW);
+
+    int i, j;
+
+    // No light or darkness
+    if (mon_rad <= 0)
+        return;
+
+    /* Remember it, if there is room */
+    if ((light_src_n < LIGHT_SRC_MAX) && (mon_rad <= LIGHT_SRC_RAD))
+    {
+        ls = &light_src[light_src_n++];
+
+        ls->m_idx = m_idx;
+        ls->r_idx = m_ptr->r_idx;
+        ls->fy = fy;
+        ls->fx = fx;
+        ls->n = 0;
+    }
+    else
+    {
+        light_src_lost = true;
+    }
+
+    for (i = -mon_rad; i <= mon_rad; i++)
+    {
+        for (j = -mon_rad; j <= mon_rad; j++)
+        {
+            int y = fy + i;
+            int x = fx + j;
+
+            int dist = distance(0, 0, i, j);
+
+            int amount;
+
+            // Don't darken/brighten the centre square too much
+            // if ((dist == 0) && (distance(py,px,fy,fx) == 1)) dist++;
+
+            if (!in_bounds(y, x) || (dist > mon_rad) || !los(fy, fx, y, x))
+                continue;
+
+            // Only set it if the player can see it
+            if ((distance(py, px, y, x) > MAX_SIGHT)
+                || !(cave_info[y][x] & (CAVE_VIEW)))
+                continue;
+
+            if ((cave_info[y][x] & (CAVE_WALL))
+                && !same_side_of_wall_as_player(y, x, fy, fx))
+                continue;
+
+            // Glowing monsters lighten their own square
+            if ((i == 0) && (j == 0) && glow)
+                amount = 1;
+
+            // Brighten the square
+            else if (mon_light > 0)
+                amount = mon_rad + 1 - dist;
+
+            // Darken the square
+            else
+                amount = -(mon_rad + 1 - dist);
+
+            if (touch)
+                light_touch(y, x);
+
+            cave_light[y][x] += amount;
+
+            if (amount > 0)
+            {
+                light_cover[y][x]++;
+
+                /* Mark as seen */
+                cave_info[y][x] |= (CAVE_SEEN);
+            }
+
+            if (ls)
+            {
+                ls->grid[ls->n] = GRID(y, x);
+                ls->amount[ls->n] = amount;
+                ls->n++;
+            }
+        }
+    }
+}
+
 /*
  * Calculate the complete field of view using a new algorithm
  *
@@ -3448,6 +4019,7 @@ void update_view(void)
 
     bool in_pit = cave_pit_bold(p_ptr->py, p_ptr->px) && !p_ptr->leaping;
 
+
     /*** Step 0 -- Begin ***/
 
     /* Save the old "view" grids for later */
@@ -3721,6 +4293,15 @@ void update_view(void)
         }
     }
 
+    /* Remember what the player's own view makes "CAVE_SEEN" */
+    for (i = 0; i < fast_view_n; i++)
+    {
+        g = fast_view_g[i];
+
+        light_base[GRID_Y(g)][GRID_X(g)]
+            = (fast_cave_info[g] & (CAVE_SEEN)) ? true : false;
+    }
+
     /*** Step 2b -- handle the Sil-style light ***/
 
     /* this is the only step that even looks at these light values */
@@ -3739,6 +4320,8 @@ void update_view(void)
             {
                 cave_light[i][j] = 0;
             }
+
+            light_cover[i][j] = 0;
         }
     }
 
@@ -3782,97 +4365,17 @@ void update_view(void)
     }
 
     // Sil: generate darkness or light for the all the monsters
+    light_src_n = 0;
+    light_src_lost = false;
+
     for (k = 1; k < mon_max; k++) // Sil-x: changed to mon_max from
                                   // z_info->m_max. I think I'm right about this
     {
-        /* Check the k'th monster */
-        monster_type* m_ptr = &mon_list[k];
-        monster_race* r_ptr = &r_info[m_ptr->r_idx];
-
         /* Skip dead monsters */
-        if (!m_ptr->r_idx)
+        if (!mon_list[k].r_idx)
             continue;
 
-        /* Access the location */
-        fx = m_ptr->fx;
-        fy = m_ptr->fy;
-
-        int mon_light = r_ptr->light;
-        int mon_rad = ABS(mon_light);
-
-        bool glow = r_ptr->flags2 & (RF2_GLOW);
-
-        // Do darkness or light for this monster
-        if (mon_rad > 0)
-        {
-            for (i = -mon_rad; i <= mon_rad; i++)
-            {
-                for (j = -mon_rad; j <= mon_rad; j++)
-                {
-                    int y = fy + i;
-                    int x = fx + j;
-
-                    int dist = distance(0, 0, i, j);
-
-                    g = GRID(y, x);
-
-                    info = fast_cave_info[g];
-
-                    // Don't darken/brighten the centre square too much
-                    // if ((dist == 0) && (distance(py,px,fy,fx) == 1)) dist++;
-
-                    if (in_bounds(y, x) && (dist <= mon_rad)
-                        && los(fy, fx, y, x))
-                    {
-                        // Only set it if the player can see it
-                        if ((distance(py, px, y, x) <= MAX_SIGHT)
-                            && (info & (CAVE_VIEW)))
-                        {
-                            if (((cave_info[y][x] & (CAVE_WALL))
-                                    && same_side_of_wall_as_player(
-                                        y, x, fy, fx))
-                                || !(cave_info[y][x] & (CAVE_WALL)))
-                            {
-                                // Glowing monsters lighten their own square
-                                if ((i == 0) && (j == 0) && glow)
-                                {
-                                    cave_light[y][x] += 1;
-
-                                    /* Mark as seen */
-                                    info |= (CAVE_SEEN);
-
-                                    /* Save cave info */
-                                    fast_cave_info[g] = info;
-
-                                    /* Save in array */
-                                    fast_view_g[fast_view_n++] = g;
-                                }
-
-                                // Brighten the square
-                                else if (mon_light > 0)
-                                {
-                                    cave_light[y][x] += mon_rad + 1 - dist;
-
-                                    /* Mark as seen */
-                                    info |= (CAVE_SEEN);
-
-                                    /* Save cave info */
-                                    fast_cave_info[g] = info;
-
-                                    /* Save in array */
-                                    fast_view_g[fast_view_n++] = g;
-                                }
-                                // Darken the square
-                                else
-                                {
-                                    cave_light[y][x] -= mon_rad + 1 - dist;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
+        light_src_add(k, false);
     }
 
     // Sil: generate darkness or light for the all the objects
@@ -3939,6 +4442,7 @@ void update_view(void)
                                 if (obj_light > 0)
                                 {
                                     cave_light[y][x] += obj_rad + 1 - dist;
+                                    light_cover[y][x]++;
 
                                     /* Mark as seen */
                                     info |= (CAVE_SEEN);
@@ -4021,11 +4525,8 @@ void update_view(void)
             y = GRID_Y(g);
             x = GRID_X(g);
 
-            /* Note */
-            note_spot(y, x);
-
-            /* Redraw */
-            lite_spot(y, x);
+            /* Note (and queue the redraw) */
+            note_spot(y, x);
         }
     }
 
@@ -4070,7 +4571,7 @@ void update_view(void)
             x = GRID_X(g);
 
             /* Redraw */
-            lite_spot(y, x);
+            queue_spot(y, x);
         }
     }
 
@@ -4084,7 +4585,7 @@ void update_view(void)
                 && !(cave_info[i][j] & (CAVE_SEEN)))
             {
                 /* Redraw */
-                lite_spot(i, j);
+                queue_spot(i, j);
             }
         }
     }
@@ -4210,6 +4711,174 @@ void update_view(void)
 
     /* Save 'view_n' */
     view_n = fast_view_n;
+
+    /* The hiding places have changed */
+    safety_stale = true;
+}
+
+/*
+ * Bring "cave_light" up to date after monster light sources have moved,
+ * appeared or gone, without recalculating the player's view.
+ *
+ * Each remembered source whose monster has moved or gone has its old
+ * contribution taken away, and each light-bearing monster without one is
+ * lit afresh.  Then only the grids whose light changed are brought up to
+ * date, with the same rules that "update_view()" uses for all of them.
+ *
+ * This must only be used when nothing but monster light has changed since
+ * the last "update_view()", which is what "PU_UPDATE_LIGHT" is for.
+ */
+void update_light(void)
+{
+    int py = p_ptr->py;
+    int px = p_ptr->px;
+
+    int player_rad = ABS(p_ptr->cur_light);
+
+    int i, k, n;
+
+    /* Cannot be done incrementally */
+    if (light_src_lost || curse_flag_count(CUR_LIGHTP))
+    {
+        update_view();
+        return;
+    }
+
+    light_touch_n = 0;
+
+    /* Take away the light of monsters which have moved or gone */
+    for (i = n = 0; i < light_src_n; i++)
+    {
+        light_src_type* ls = &light_src[i];
+        monster_type* m_ptr = &mon_list[ls->m_idx];
+
+        /* Unchanged */
+        if ((m_ptr->r_idx == ls->r_idx) && (m_ptr->fy == ls->fy)
+            && (m_ptr->fx == ls->fx))
+        {
+            if (n != i)
+                COPY(&light_src[n], ls, light_src_type);
+            n++;
+            continue;
+        }
+
+        for (k = 0; k < ls->n; k++)
+        {
+            int y = GRID_Y(ls->grid[k]);
+            int x = GRID_X(ls->grid[k]);
+
+            light_touch(y, x);
+
+            cave_light[y][x] -= ls->amount[k];
+
+            if (ls->amount[k] > 0)
+                light_cover[y][x]--;
+        }
+    }
+    light_src_n = n;
+
+    /* Light the monsters which have no (remaining) light source */
+    for (k = 1; k < mon_max; k++)
+    {
+        monster_type* m_ptr = &mon_list[k];
+
+        /* Skip dead monsters and those without light */
+        if (!m_ptr->r_idx || !r_info[m_ptr->r_idx].light)
+            continue;
+
+        /* Already lit */
+        for (i = 0; i < n; i++)
+        {
+            if (light_src[i].m_idx == k)
+                break;
+        }
+        if (i < n)
+            continue;
+
+        light_src_add(k, true);
+    }
+
+    /* Bring the changed grids up to date */
+    for (i = 0; i < light_touch_n; i++)
+    {
+        int y = GRID_Y(light_touch_g[i]);
+        int x = GRID_X(light_touch_g[i]);
+
+        u16b info = cave_info[y][x];
+
+        bool was_seen = (info & (CAVE_SEEN)) ? true : false;
+        bool seen = light_base[y][x] || (light_cover[y][x] > 0);
+
+        light_touched[y][x] = false;
+
+        // Remove 'seen' flag from squares that have zero or less light
+        if (cave_light[y][x] <= 0)
+        {
+            seen = false;
+
+            /* Hack -- Forget "boring" grids */
+            if (cave_floorlike_bold(y, x) && (info & (CAVE_GLOW)))
+            {
+                /* Forget */
+                cave_info[y][x] &= ~(CAVE_MARK);
+            }
+        }
+
+        /* Handle blindness */
+        if (p_ptr->blind)
+            seen = false;
+
+        if (seen)
+            cave_info[y][x] |= (CAVE_SEEN);
+        else
+            cave_info[y][x] &= ~(CAVE_SEEN);
+
+        /* Was not "CAVE_SEEN", is now "CAVE_SEEN" */
+        if (seen && !was_seen)
+            note_spot(y, x);
+
+        /* Otherwise redraw any change in brightness */
+        else if ((seen != was_seen) || (cave_light[y][x] != light_touch_old[i]))
+            queue_spot(y, x);
+
+        // Sil: disturb the player when the lighting changes unexpectedly
+        if (in_bounds_fully(y, x) && ((y != py) || (x != px))
+            && (info & (CAVE_OLD_VIEW)) && (info & (CAVE_VIEW))
+            && ((p_ptr->old_light >= 0)
+                || (distance(py, px, y, x) > player_rad + 1)))
+        {
+            // check recently darkened squares
+            if ((info & (CAVE_OLD_LIT)) && (cave_light[y][x] <= 0)
+                && !((info & (CAVE_OLD_TORCH))
+                    && (distance(py, px, y, x) > player_rad)))
+            {
+                disturb(0, 0);
+            }
+
+            // check recently lit squares
+            if (!(info & (CAVE_OLD_LIT)) && (cave_light[y][x] > 0)
+                && !(!(info & (CAVE_OLD_TORCH))
+                    && (distance(py, px, y, x) <= player_rad)))
+            {
+                disturb(0, 0);
+            }
+        }
+
+        // store lighting information for the next check
+        if (cave_light[y][x] > 0)
+            cave_info[y][x] |= (CAVE_OLD_LIT);
+        else
+            cave_info[y][x] &= ~(CAVE_OLD_LIT);
+
+        /* A monster here may have come into (or gone out of) sight */
+        if (cave_m_idx[y][x] > 0)
+            update_mon(cave_m_idx[y][x], false);
+    }
+
+    light_touch_n = 0;
+
+    /* The hiding places have changed */
+    safety_stale = true;
 }
 
 /*
@@ -4227,6 +4896,114 @@ int flow_dist(int which_flow, int y, int x)
     return (dist);
 }
 
+/*
+ * A small cache of wandering flows, keyed by their centre and by what the
+ * monster they were built for could get through: its race, whether it is
+ * alert, whether it is fleeing, and its Will and Perception (for glyphs and
+ * doors).  Wandering flows only take the terrain into account (see
+ * "cave_passable_terrain()") so they can be shared by any group that matches.
+ * Entries are replaced least recently used first and all are discarded
+ * whenever the terrain changes.
+ */
+static byte flow_cache_cost[FLOW_CACHE_SIZE][MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+static byte flow_cache_y[FLOW_CACHE_SIZE];
+static byte flow_cache_x[FLOW_CACHE_SIZE];
+static u32b flow_cache_key[FLOW_CACHE_SIZE];
+static s16b flow_cache_wil[FLOW_CACHE_SIZE];
+static s16b flow_cache_per[FLOW_CACHE_SIZE];
+static u32b flow_cache_used[FLOW_CACHE_SIZE];
+static u32b flow_cache_clock = 0;
+static int flow_cache_n = 0;
+
+/*
+ * Forget all the cached wandering flows (the dungeon has changed)
+ */
+void wipe_flow_cache(void)
+{
+    flow_cache_n = 0;
+}
+
+/*
+ * The race and state of the monster a wandering flow is built for
+ */
+static u32b flow_cache_race(monster_type* m_ptr)
+{
+    u32b key = (u32b)m_ptr->r_idx;
+
+    if (m_ptr->alertness >= ALERTNESS_ALERT)
+        key |= 0x10000L;
+    if (m_ptr->stance == STANCE_FLEEING)
+        key |= 0x20000L;
+
+    return (key);
+}
+
+/*
+ * Finds the cached flow for the given centre and monster, or -1 if there is
+ * none.
+ */
+static int flow_cache_find(int cy, int cx, monster_type* m_ptr)
+{
+    u32b key = flow_cache_race(m_ptr);
+    int wil = monster_skill(m_ptr, S_WIL);
+    int per = monster_skill(m_ptr, S_PER);
+    int i;
+
+    for (i = 0; i < flow_cache_n; i++)
+    {
+        if ((flow_cache_y[i] == cy) && (flow_cache_x[i] == cx)
+            && (flow_cache_key[i] == key) && (flow_cache_wil[i] == wil)
+            && (flow_cache_per[i] == per))
+        {
+            flow_cache_used[i] = ++flow_cache_clock;
+            return (i);
+        }
+    }
+
+    return (-1);
+}
+
+/*
+ * Remembers a freshly built wandering flow, replacing the old one for the
+ * same centre and monster if there is one, and otherwise evicting the
+ * stalest entry if the cache is full.
+ */
+static void flow_cache_store(
+    int cy, int cx, monster_type* m_ptr, int which_flow)
+{
+    int i;
+    int slot = flow_cache_find(cy, cx, m_ptr);
+
+    if (slot >= 0)
+    {
+        /* Refresh it */
+    }
+    else if (flow_cache_n < FLOW_CACHE_SIZE)
+    {
+        slot = flow_cache_n++;
+    }
+    else
+    {
+        slot = 0;
+
+        for (i = 1; i < FLOW_CACHE_SIZE; i++)
+        {
+            if (flow_cache_used[i] < flow_cache_used[slot])
+                slot = i;
+        }
+    }
+
+    flow_cache_y[slot] = cy;
+    flow_cache_x[slot] = cx;
+    flow_cache_key[slot] = flow_cache_race(m_ptr);
+    flow_cache_wil[slot] = monster_skill(m_ptr, S_WIL);
+    flow_cache_per[slot] = monster_skill(m_ptr, S_PER);
+    flow_cache_used[slot] = ++flow_cache_clock;
+
+    C_COPY(flow_cache_cost[slot], cave_cost[which_flow], MAX_DUNGEON_HGT,
+        byte[MAX_DUNGEON_WID]);
+}
+
 /*
  * Sil needs various 'flows', which are arrays of the same size as the map,
  * with a number for each map square.
@@ -4310,8 +5087,51 @@ void update_flow(int cy, int cx, int which_flow)
         // (these are attempted to be reprocessed on save game load)
         if (!found)
             return;
+
+        // reuse the flow if a similar group was recently sent here, unless
+        // this is a refresh of the flow to pick up changes in the dungeon
+        if ((flow_center_y[which_flow] == cy)
+            && (flow_center_x[which_flow] == cx))
+            i = -1;
+        else
+            i = flow_cache_find(cy, cx, m_ptr);
+
+        if (i >= 0)
+        {
+            C_COPY(cave_cost[which_flow], flow_cache_cost[i], MAX_DUNGEON_HGT,
+                byte[MAX_DUNGEON_WID]);
+
+            flow_center_y[which_flow] = cy;
+            flow_center_x[which_flow] = cx;
+            update_center_y[which_flow] = cy;
+            update_center_x[which_flow] = cx;
+
+            // monsters the flow reaches need to re-consider their targets,
+            // just as if it had been rebuilt
+            for (i = 1; i < mon_max; i++)
+            {
+                monster_type* n_ptr = &mon_list[i];
+
+                if (!n_ptr->r_idx)
+                    continue;
+                if ((n_ptr->fy == cy) && (n_ptr->fx == cx))
+                    continue;
+
+                if (cave_cost[which_flow][n_ptr->fy][n_ptr->fx] < FLOW_MAX_DIST)
+                {
+                    n_ptr->target_y = 0;
+                    n_ptr->target_x = 0;
+                }
+            }
+
+            return;
+        }
     }
 
+    /* Fleeing monsters judge their hiding places by the player noise */
+    if (which_flow == FLOW_PLAYER_NOISE)
+        safety_stale = true;
+
     /* Save the new flow epicenter */
     flow_center_y[which_flow] = cy;
     flow_center_x[which_flow] = cx;
@@ -4396,8 +5216,12 @@ void update_flow(int cy, int cx, int which_flow)
                     if (monster_flow)
                     {
                         // get the percentage chance of the monster being able
-                        // to move onto that square
-                        int chance = cave_passable_mon(m_ptr, y2, x2, &bash);
+                        // to move onto that square (wandering flows ignore
+                        // other monsters, which are dealt with as they are
+                        // met)
+                        int chance = (which_flow >= FLOW_WANDERING_HEAD)
+                            ? cave_passable_terrain(m_ptr, y2, x2, &bash)
+                            : cave_passable_mon(m_ptr, y2, x2, &bash);
 
                         // if there is any chance, then convert it to a number
                         // of turns
@@ -4497,6 +5321,317 @@ void update_flow(int cy, int cx, int which_flow)
             next_cycle = 1;
         }
     }
+
+    /* Remember wandering flows for other groups heading the same way (but
+     * not while the player stands on a glyph, which then counts as broken) */
+    if ((which_flow >= FLOW_WANDERING_HEAD)
+        && (which_flow <= FLOW_WANDERING_TAIL)
+        && (cave_feat[p_ptr->py][p_ptr->px] != FEAT_GLYPH))
+    {
+        flow_cache_store(cy, cx, m_ptr, which_flow);
+    }
+}
+
+/*
+ * Is a grid one that a typical monster could walk through while fleeing?
+ */
+static bool safety_passable(int y, int x)
+{
+    return (cave_floor_bold(y, x) || cave_any_closed_door_bold(y, x));
+}
+
+/*
+ * Builds one of the shared safety maps used by fleeing monsters.
+ *
+ * Every grid gets the number of steps to the nearest hiding place, that is
+ * a passable grid the player cannot see which is not a one-grid cul-de-sac.
+ * Only grids the player's noise can reach are considered, and we don't look
+ * further than HIDE_RANGE steps.  Grids from which no hiding place is in
+ * range are left at FLOW_MAX_DIST.
+ *
+ * If "stairs" is true, stairs count as hiding places too, even in plain
+ * view, as the monsters using that map can escape by them.
+ */
+static void update_safety_aux(byte map[][MAX_DUNGEON_WID], bool stairs)
+{
+    int y, x, y2, x2, d, i;
+    int head = 0;
+    int tail = 0;
+
+    static u16b safety_queue[MAX_DUNGEON_HGT * MAX_DUNGEON_WID];
+
+    /* Erase the old map */
+    for (y = 0; y < MAX_DUNGEON_HGT; y++)
+    {
+        for (x = 0; x < MAX_DUNGEON_WID; x++)
+        {
+            map[y][x] = FLOW_MAX_DIST;
+        }
+    }
+
+    /* Seed the map with the hiding places */
+    for (y = 0; y < p_ptr->cur_map_hgt; y++)
+    {
+        for (x = 0; x < p_ptr->cur_map_wid; x++)
+        {
+            bool has_escape = false;
+
+            /* Stairs are always a way out (unless the player is on them) */
+            if (stairs && cave_stair_bold(y, x)
+                && !((y == p_ptr->py) && (x == p_ptr->px)))
+            {
+                map[y][x] = 0;
+                safety_queue[tail++] = GRID(y, x);
+                continue;
+            }
+
+            if (!safety_passable(y, x) || player_can_see_bold(y, x))
+                continue;
+
+            /* Must be connected to the player */
+            if (cave_cost[FLOW_PLAYER_NOISE][y][x] >= FLOW_MAX_DIST)
+                continue;
+
+            /* Ignore one-grid cul-de-sacs */
+            for (d = 0; d < 8; d++)
+            {
+                y2 = y + ddy_ddd[d];
+                x2 = x + ddx_ddd[d];
+
+                if (in_bounds(y2, x2) && safety_passable(y2, x2)
+                    && !player_can_see_bold(y2, x2))
+                {
+                    has_escape = true;
+                    break;
+                }
+            }
+            if (!has_escape)
+                continue;
+
+            map[y][x] = 0;
+            safety_queue[tail++] = GRID(y, x);
+        }
+    }
+
+    /* Spread outwards from the hiding places */
+    while (head < tail)
+    {
+        int g = safety_queue[head++];
+
+        y = GRID_Y(g);
+        x = GRID_X(g);
+
+        /* Don't look too far */
+        if (map[y][x] >= HIDE_RANGE)
+            continue;
+
+        for (i = 0; i < 8; i++)
+        {
+            y2 = y + ddy_ddd[i];
+            x2 = x + ddx_ddd[i];
+
+            if (!in_bounds(y2, x2))
+                continue;
+
+            /* Already reached */
+            if (map[y2][x2] < FLOW_MAX_DIST)
+                continue;
+
+            /* Monsters can't flee through the player */
+            if ((y2 == p_ptr->py) && (x2 == p_ptr->px))
+                continue;
+
+            if (!safety_passable(y2, x2))
+                continue;
+
+            map[y2][x2] = map[y][x] + 1;
+            safety_queue[tail++] = GRID(y2, x2);
+        }
+    }
+}
+
+/*
+ * Builds the shared safety maps used by fleeing monsters: "cave_safety",
+ * and "cave_safety_stair" for those which can escape by the stairs (see
+ * "update_safety_aux()").
+ *
+ * The maps depend only on the player's view and the player noise, so they
+ * are built at most once between calls to "update_view()" and rebuilt
+ * lazily the first time a monster needs them afterwards.  This saves every
+ * member of a fleeing group from repeating the same local search in
+ * "find_safety()".
+ */
+void update_safety(void)
+{
+    update_safety_aux(cave_safety, false);
+    update_safety_aux(cave_safety_stair, true);
+
+    /* The maps are now current */
+    safety_stale = false;
+}
+
+/*
+ * Allocate an empty dungeon level
+ */
+level_type* level_make(void)
+{
+    level_type* l;
+
+    MAKE(l, level_type);
+
+    C_MAKE(l->info, MAX_DUNGEON_HGT, u16b_256);
+    C_MAKE(l->feat, MAX_DUNGEON_HGT, byte_wid);
+    C_MAKE(l->color, MAX_DUNGEON_HGT, byte_wid);
+    C_MAKE(l->light, MAX_DUNGEON_HGT, s16b_wid);
+    C_MAKE(l->o_idx, MAX_DUNGEON_HGT, s16b_wid);
+    C_MAKE(l->m_idx, MAX_DUNGEON_HGT, s16b_wid);
+    C_MAKE(l->when, MAX_DUNGEON_HGT, byte_wid);
+    C_MAKE(l->cost, MAX_FLOWS, byte_map);
+
+    C_MAKE(l->o_list, z_info->o_max, object_type);
+    C_MAKE(l->mon_list, MAX_MONSTERS, monster_type);
+
+    /* Nothing allocated yet (index zero is never used) */
+    l->o_max = 1;
+    l->mon_max = 1;
+
+    /* No styles chosen yet */
+    l->style = -1;
+    l->vault_style = -1;
+
+    l->scent_when = 250;
+
+    return (l);
+}
+
+/*
+ * Free a dungeon level (if it is the current one, there is then none)
+ */
+void level_free(level_type* l)
+{
+    if (!l)
+        return;
+
+    if (l == cave_level)
+        cave_level = NULL;
+
+    FREE(l->info);
+    FREE(l->feat);
+    FREE(l->color);
+    FREE(l->light);
+    FREE(l->o_idx);
+    FREE(l->m_idx);
+    FREE(l->when);
+    FREE(l->cost);
+
+    FREE(l->o_list);
+    FREE(l->mon_list);
+
+    FREE(l);
+}
+
+/*
+ * Make "l" the current dungeon level.
+ *
+ * The counters and styles of the old level are kept in its record, and
+ * anything worked out from its grids (the view, the flow cache, the safety
+ * maps, the lights, the remembered look of the map and the player's
+ * vulnerability) is forgotten.  Nothing is redrawn.
+ */
+void level_set(level_type* l)
+{
+    level_type* old = cave_level;
+
+    if (old)
+    {
+        u16b* fast_cave_info = &cave_info[0][0];
+        int i;
+
+        /* Quietly forget the view */
+        for (i = 0; i < view_n; i++)
+        {
+            fast_cave_info[view_g[i]] &= ~(CAVE_VIEW | CAVE_SEEN | CAVE_FIRE);
+        }
+
+        view_n = 0;
+
+        /* Keep the counters */
+        old->o_max = o_max;
+        old->o_cnt = o_cnt;
+        old->mon_max = mon_max;
+        old->mon_cnt = mon_cnt;
+        old->num_repro = num_repro;
+        old->feeling = feeling;
+        old->rating = rating;
+        old->good_item_flag = good_item_flag;
+        old->num_trap_on_level = num_trap_on_level;
+        my_strcpy(old->g_vault_name, g_vault_name, sizeof(old->g_vault_name));
+        old->do_feeling = do_feeling;
+
+        old->style = g_level_primary_style;
+        old->vault_style = g_vault_primary_style;
+        C_COPY(old->floor_choice, g_level_floor_choice, 64, byte);
+        C_COPY(old->door_choice, g_level_door_choice, 64, byte);
+        C_COPY(old->vault_floor_choice, g_vault_floor_choice, 64, byte);
+        C_COPY(old->vault_door_choice, g_vault_door_choice, 64, byte);
+
+        old->scent_when = scent_when;
+        C_COPY(old->flow_center_y, flow_center_y, MAX_FLOWS, byte);
+        C_COPY(old->flow_center_x, flow_center_x, MAX_FLOWS, byte);
+        C_COPY(old->update_center_y, update_center_y, MAX_FLOWS, byte);
+        C_COPY(old->update_center_x, update_center_x, MAX_FLOWS, byte);
+        C_COPY(old->wandering_pause, wandering_pause, MAX_FLOWS, s16b);
+    }
+
+    cave_level = l;
+
+    /* Use its planes */
+    cave_info = l->info;
+    cave_feat = l->feat;
+    cave_color = l->color;
+    cave_light = l->light;
+    cave_o_idx = l->o_idx;
+    cave_m_idx = l->m_idx;
+    cave_when = l->when;
+    cave_cost = l->cost;
+
+    o_list = l->o_list;
+    mon_list = l->mon_list;
+
+    /* And its counters */
+    o_max = l->o_max;
+    o_cnt = l->o_cnt;
+    mon_max = l->mon_max;
+    mon_cnt = l->mon_cnt;
+    num_repro = l->num_repro;
+    feeling = l->feeling;
+    rating = l->rating;
+    good_item_flag = l->good_item_flag;
+    num_trap_on_level = l->num_trap_on_level;
+    my_strcpy(g_vault_name, l->g_vault_name, sizeof(g_vault_name));
+    do_feeling = l->do_feeling;
+
+    g_level_primary_style = l->style;
+    g_vault_primary_style = l->vault_style;
+    C_COPY(g_level_floor_choice, l->floor_choice, 64, byte);
+    C_COPY(g_level_door_choice, l->door_choice, 64, byte);
+    C_COPY(g_vault_floor_choice, l->vault_floor_choice, 64, byte);
+    C_COPY(g_vault_door_choice, l->vault_door_choice, 64, byte);
+
+    scent_when = l->scent_when;
+    C_COPY(flow_center_y, l->flow_center_y, MAX_FLOWS, byte);
+    C_COPY(flow_center_x, l->flow_center_x, MAX_FLOWS, byte);
+    C_COPY(update_center_y, l->update_center_y, MAX_FLOWS, byte);
+    C_COPY(update_center_x, l->update_center_x, MAX_FLOWS, byte);
+    C_COPY(wandering_pause, l->wandering_pause, MAX_FLOWS, s16b);
+
+    /* Forget what was worked out from the old grids */
+    wipe_flow_cache();
+    safety_stale = true;
+    light_src_lost = true;
+    wipe_map_memo();
+    overview_stale = true;
+    wipe_vuln_memo();
 }
 
 /*
@@ -4893,6 +6028,12 @@ void cave_set_feat_with_color(int y, int x, int feat, int color)
         cave_info[y][x] &= ~(CAVE_WALL);
     }
 
+    /* Monsters sizing up the player need to look again */
+    note_player_neighbour(y, x);
+
+    /* Wandering monsters need to find new routes */
+    wipe_flow_cache();
+
     /* Notice/Redraw */
     if (character_dungeon)
     {
@@ -4900,7 +6041,7 @@ void cave_set_feat_with_color(int y, int x, int feat, int color)
         note_spot(y, x);
 
         /* Redraw */
-        lite_spot(y, x);
+        queue_spot(y, x);
     }
 }
 
@@ -5750,6 +6891,9 @@ void disturb(int stop_stealth, int unused_flag)
         stop_stealth_mode = true;
     }
 
+    /* Show the player anything a limited refresh held back */
+    fresh_if_pending();
+
     /* Flush the input */
     flush();
 }
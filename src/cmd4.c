@@ -224,6 +224,9 @@ void do_cmd_redraw(void)
     /* Hack -- React to changes */
     Term_xtra(TERM_XTRA_REACT, 0);
 
+    /* Forget how the map looked (the visuals may have changed) */
+    wipe_map_memo();
+
     /* Combine and Reorder the pack (later) */
     p_ptr->notice |= (PN_COMBINE | PN_REORDER);
 
@@ -8973,6 +8976,9 @@ void do_cmd_visuals(void)
                 {
                     askfor_shade(&f_info[f].x_attr, 22);
                 }
+
+                /* The map must be worked out again */
+                wipe_map_memo();
             }
         }
 
@@ -297,6 +297,12 @@ static const depth_wall_tier wall_depth_tiers[MAX_WALL_DEPTH_TIERS] = {
 #define FLOW_MONSTER_NOISE FLOW_WANDERING_TAIL + 2
 #define MAX_FLOWS FLOW_WANDERING_TAIL + 4
 
+/*
+ * The number of wandering flows remembered by destination so that groups
+ * heading for the same place can share the work of building them.
+ */
+#define FLOW_CACHE_SIZE 8
+
 /*
  * Maximum distance from the character to store flow (noise) information
  */
@@ -1071,6 +1077,46 @@ static const depth_wall_tier wall_depth_tiers[MAX_WALL_DEPTH_TIERS] = {
 // Vaults
 #define MAX_GREATER_VAULTS 8
 
+/*
+ * The vault index (see "init_alloc()") has a table of candidates for each
+ * vault type, depth, and combination of the VAULT_PICK_XXX restrictions
+ */
+#define VAULT_TYP_MIN 6 /* Interesting rooms */
+#define VAULT_TYP_MAX 9 /* Morgoth's vault */
+#define VAULT_PICK_FORGE 0x01 /* Only vaults with a forge */
+#define VAULT_PICK_TEST 0x02 /* Only vaults marked TEST */
+#define VAULT_PICK_MAX 4
+#define VAULT_INDEX_MAX                                                        \
+    ((VAULT_TYP_MAX - VAULT_TYP_MIN + 1) * (MORGOTH_DEPTH + 1) * VAULT_PICK_MAX)
+#define VAULT_INDEX(T, D, P)                                                   \
+    ((((T)-VAULT_TYP_MIN) * (MORGOTH_DEPTH + 1) + (D)) * VAULT_PICK_MAX + (P))
+#define VAULT_WEIGHT 0x10000L /* Weight of a vault with rarity 1 */
+
+/*
+ * Reasons for throwing away a level during generation (see "gen_fail()")
+ */
+#define GEN_FAIL_FORGE 0 /* Couldn't build the guaranteed forge */
+#define GEN_FAIL_ROOMS 1 /* Not enough rooms */
+#define GEN_FAIL_PIECES 2 /* Couldn't join up the rooms */
+#define GEN_FAIL_STAIRS 3 /* Couldn't place the stairs */
+#define GEN_FAIL_STREAMER 4 /* Couldn't build a streamer */
+#define GEN_FAIL_PLAYER 5 /* Couldn't place the rubble or the player */
+#define GEN_FAIL_ACCESS 6 /* Stairs out of reach of the player */
+#define GEN_FAIL_OBJECTS 7 /* Too many objects */
+#define GEN_FAIL_MONSTERS 8 /* Too many monsters */
+#define GEN_FAIL_MAX 9
+
+/*
+ * Vaults noted for the level being generated (see "gen_vault_idx")
+ */
+#define GEN_VAULT_MAX 16
+
+/*
+ * Sets of candidates kept for each of the monster and object allocation
+ * tables (see "alloc_cache_find()")
+ */
+#define ALLOC_CACHE_MAX 16
+
 /*** Important artefact indexes (see "lib/edit/artefact.txt") ***/
 
 #define ART_MAEGLIN 32
@@ -1573,7 +1619,7 @@ static const depth_wall_tier wall_depth_tiers[MAX_WALL_DEPTH_TIERS] = {
 /* xxx (many) */
 #define PU_FORGET_VIEW 0x00010000L /* Forget field of view */
 #define PU_UPDATE_VIEW 0x00020000L /* Update field of view */
-/* xxx */
+#define PU_UPDATE_LIGHT 0x00040000L /* Update monster light only */
 /* xxx */
 #define PU_MONSTERS 0x10000000L /* Update monsters */
 #define PU_DISTANCE 0x20000000L /* Update distances */
@@ -1609,7 +1655,7 @@ static const depth_wall_tier wall_depth_tiers[MAX_WALL_DEPTH_TIERS] = {
 #define PR_RESIST 0X00800000L /* Display Resistances */
 #define PR_EXTRA 0x01000000L /* Display Extra Info */
 #define PR_BASIC 0x02000000L /* Display Basic Info */
-/* xxx */
+#define PR_SPOTS 0x04000000L /* Display changed map grids */
 #define PR_MAP 0x08000000L /* Display Map */
 /* xxx (many) */
 
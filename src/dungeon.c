@@ -1735,7 +1735,7 @@ static void process_player(void)
 
         /* Redraw stuff (if needed) */
         if (p_ptr->window)
-            window_stuff();
+            window_stuff_limited();
 
         // Sil-y: have to update the player bonuses at every turn with
         // sprinting, dodging etc.
@@ -1762,7 +1762,7 @@ static void process_player(void)
 
         /* Redraw stuff (if needed) */
         if (p_ptr->window)
-            window_stuff();
+            window_stuff_limited();
 
         /* Place the cursor on the player or target */
         if (hilite_player)
@@ -1777,8 +1777,8 @@ static void process_player(void)
         else if (cheat_light)
             display_light_map();
 
-        /* Refresh */
-        Term_fresh();
+        /* Refresh (coalesced while running or resting) */
+        fresh_limited();
 
         /* Hack -- Pack Overflow if needed */
         check_pack_overflow();
@@ -2847,7 +2847,7 @@ static void dungeon(void)
 
         /* Redraw stuff */
         if (p_ptr->window) {
-            window_stuff();
+            window_stuff_limited();
         }
 
         /* Place the cursor on the player or target */
@@ -2883,7 +2883,7 @@ static void dungeon(void)
 
         /* Redraw stuff */
         if (p_ptr->window)
-            window_stuff();
+            window_stuff_limited();
 
         /* Place the cursor on the player or target */
         if (hilite_player)
@@ -2916,7 +2916,7 @@ static void dungeon(void)
 
         /* Window stuff */
         if (p_ptr->window)
-            window_stuff();
+            window_stuff_limited();
 
         /* Place the cursor on the player or target */
         if (hilite_player)
@@ -3415,6 +3415,14 @@ PlayResult play_game(void)
     /* React to changes */
     Term_xtra(TERM_XTRA_REACT, 0);
 
+    /* Build a recorded level in place of the saved one, if requested */
+    if (gen_replay_set && character_dungeon)
+    {
+        wipe_o_list();
+        wipe_mon_list();
+        character_dungeon = false;
+    }
+
     /* Generate a dungeon level if needed */
     if (!character_dungeon)
     {
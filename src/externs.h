@@ -45,6 +45,7 @@ extern cptr option_text[OPT_MAX];
 extern cptr option_desc[OPT_MAX];
 extern const bool option_norm[OPT_MAX];
 extern const byte option_page[OPT_PAGE_MAX][OPT_PAGE_PER];
+extern cptr gen_fail_names[GEN_FAIL_MAX];
 extern cptr inscrip_text[MAX_INSCRIP];
 extern byte spell_info_RF4[32][3];
 extern byte spell_desire_RF4[32][2];
@@ -98,6 +99,7 @@ extern bool inkey_xtra;
 extern bool inkey_scan;
 extern bool inkey_flag;
 extern bool hide_cursor;
+extern s16b fresh_rate;
 extern byte object_generation_mode;
 extern bool shimmer_monsters;
 extern bool shimmer_objects;
@@ -129,6 +131,7 @@ extern int temp_n;
 extern u16b* temp_g;
 extern byte* temp_y;
 extern byte* temp_x;
+extern level_type* cave_level;
 extern u16b (*cave_info)[256];
 extern byte (*cave_feat)[MAX_DUNGEON_WID];
 extern byte (*cave_color)[MAX_DUNGEON_WID];
@@ -137,7 +140,10 @@ extern s16b (*cave_o_idx)[MAX_DUNGEON_WID];
 extern s16b (*cave_m_idx)[MAX_DUNGEON_WID];
 extern u32b mon_power_ave[MAX_DEPTH][CREATURE_TYPE_MAX];
 
-extern byte cave_cost[MAX_FLOWS][MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+extern byte_map* cave_cost;
+extern byte cave_safety[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+extern byte cave_safety_stair[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+extern bool safety_stale;
 extern byte (*cave_when)[MAX_DUNGEON_WID];
 extern int scent_when;
 extern byte flow_center_y[MAX_FLOWS];
@@ -165,6 +171,17 @@ extern s16b alloc_ego_size;
 extern alloc_entry* alloc_ego_table;
 extern s16b alloc_race_size;
 extern alloc_entry* alloc_race_table;
+extern alloc_cache* alloc_kind_cache;
+extern u32b alloc_kind_prep;
+extern alloc_cache* alloc_race_cache;
+extern u32b alloc_race_prep;
+extern u32b alloc_race_stamp;
+extern s32b alloc_vault_size;
+extern s16b* alloc_vault_table;
+extern u32b* alloc_vault_total;
+extern vault_index* alloc_vault_index;
+extern vault_layout* vault_layouts;
+extern vault_op* vault_ops;
 extern byte misc_to_attr[256];
 extern char misc_to_char[256];
 extern byte tval_to_attr[128];
@@ -270,6 +287,21 @@ extern byte bones_selector;
 extern int r_ghost;
 extern char ghost_name[80];
 extern char g_vault_name[80];
+extern u16b gen_fail_last[GEN_FAIL_MAX];
+extern u32b gen_fail_total[GEN_FAIL_MAX];
+extern u32b gen_msec;
+extern s16b gen_rooms;
+extern byte gen_room_y[DUN_ROOMS];
+extern byte gen_room_x[DUN_ROOMS];
+extern s16b gen_vault_n;
+extern s16b gen_vault_idx[GEN_VAULT_MAX];
+extern byte gen_vault_y[GEN_VAULT_MAX];
+extern byte gen_vault_x[GEN_VAULT_MAX];
+extern FILE* gen_dump_fff;
+extern bool gen_dump_binary;
+extern gen_record gen_last;
+extern gen_record gen_replay;
+extern bool gen_replay_set;
 extern bool skill_gain_in_progress;
 extern bool save_game_quietly;
 extern bool stop_stealth_mode;
@@ -301,20 +333,29 @@ extern bool no_light(void);
 extern bool seen_by_keen_senses(int y, int x);
 extern bool cave_valid_bold(int y, int x);
 extern bool feat_supports_lighting(int feat);
+extern void wipe_map_memo(void);
 extern void map_info(int y, int x, byte* ap, char* cp, byte* tap, char* tcp);
 extern void map_info_default(int y, int x, byte* ap, char* cp);
 extern void move_cursor_relative(int y, int x);
 extern void print_rel(char c, byte a, int y, int x);
 extern void note_spot(int y, int x);
 extern void lite_spot(int y, int x);
+extern void queue_spot(int y, int x);
+extern void prt_spots(void);
 extern void prt_map(void);
 extern void display_map(int* cy, int* cx);
 extern void do_cmd_view_map(void);
 extern errr vinfo_init(void);
 extern void forget_view(void);
 extern void update_view(void);
+extern void update_light(void);
 extern int flow_dist(int which_flow, int y, int x);
 extern void update_flow(int cy, int cx, int which_flow);
+extern void update_safety(void);
+extern level_type* level_make(void);
+extern void level_free(level_type* l);
+extern void level_set(level_type* l);
+extern void wipe_flow_cache(void);
 extern void update_smell(void);
 extern void map_feature(int y, int x);
 extern void map_area(void);
@@ -610,12 +651,17 @@ extern void clear_scorefile(void);
 extern bool autoload_alive_from_scores(void);
 
 /* generate.c */
+extern bool player_passable(int y, int x, bool ignore_rubble_and_chasms);
 extern void place_monster_by_flag(
     int y, int x, int flagset, u32b f, bool allow_unique, int max_depth);
 extern void place_random_stairs(int y, int x);
 extern byte get_nest_theme(int nestlevel);
 extern byte get_pit_theme(int pitlevel);
+extern void gen_key(char* buf, size_t max, const gen_record* rec);
+extern bool gen_key_parse(cptr key, gen_record* rec);
+extern void unring_a_bell(void);
 extern void generate_cave(void);
+extern bool generate_aside(const gen_record* rec);
 
 /* init2.c */
 extern void init_file_paths(char* path);
@@ -633,6 +679,7 @@ extern bool load_meta(void);
 
 /* melee1.c */
 extern int protection_roll(int typ, bool melee);
+extern int elem_bonus(int effect);
 extern int p_min(int typ, bool melee);
 extern int p_max(int typ, bool melee);
 extern int get_sides(int attack);
@@ -656,10 +703,13 @@ extern void do_betrayal_ring_amulet();
 /* melee2.c */
 extern bool attacker_at(int y, int x);
 extern int adj_mon_count(int y, int x);
+extern void note_player_neighbour(int y, int x);
+extern void wipe_vuln_memo(void);
 extern int get_scent(int y, int x);
 extern bool cave_exist_mon(
     monster_race* r_ptr, int y, int x, bool occupied_ok, bool can_dig);
 extern int cave_passable_mon(monster_type* m_ptr, int y, int x, bool* bash);
+extern int cave_passable_terrain(monster_type* m_ptr, int y, int x, bool* bash);
 extern void tell_allies(int y, int x, u32b flag);
 extern void process_monsters(s16b minimum_energy);
 extern void calc_morale(monster_type* m_ptr);
@@ -982,6 +1032,9 @@ extern errr fd_read(int fd, char* buf, size_t n);
 extern errr fd_write(int fd, cptr buf, size_t n);
 extern errr fd_close(int fd);
 extern errr check_modification_date(int fd, cptr template_file);
+extern u32b clock_msec(void);
+extern void fresh_limited(void);
+extern void fresh_if_pending(void);
 extern void text_to_ascii(char* buf, size_t len, cptr str);
 extern void ascii_to_text(char* buf, size_t len, cptr str);
 extern int macro_find_exact(cptr pat);
@@ -1037,6 +1090,10 @@ extern void pause_line(int row);
 extern void request_command(void);
 extern int int_exp(int base, int power);
 extern int damroll(int num, int sides);
+extern alloc_cache* alloc_cache_find(
+    alloc_cache* cache, u32b key, u32b prep, u32b stamp);
+extern void alloc_cache_add(alloc_cache* c, int i, int weight);
+extern int alloc_cache_pick(const alloc_cache* c);
 extern bool is_a_vowel(int ch);
 extern int color_char_to_attr(char c);
 extern int color_text_to_attr(cptr name);
@@ -1083,6 +1140,7 @@ extern void notice_stuff(void);
 extern void update_stuff(void);
 extern void redraw_stuff(void);
 extern void window_stuff(void);
+extern void window_stuff_limited(void);
 extern void handle_stuff(void);
 extern int weight_limit(void);
 extern void calc_voice(void);
@@ -1213,6 +1271,21 @@ extern void do_cmd_debug(void);
 extern void do_cmd_wiz_unhide(int d);
 #endif /* ALLOW_DEBUG */
 
+/* sim.c */
+extern long sim_combat(
+    FILE* fff, int r_min, int r_max, int fights, bool archery, u32b seed);
+extern void sim_run(cptr spec);
+
+/* levstat.c */
+extern void init_levstat_term(void);
+extern void levstat_run(cptr spec);
+
+/* levdump.c */
+extern void gen_dump(void);
+extern bool gen_dump_copy(FILE* in, FILE* out, bool binary);
+extern errr gen_dump_open(cptr dest);
+extern void gen_dump_close(void);
+
 #ifdef ALLOW_SPOILERS
 
 /* wizard1.c */
@@ -444,6 +444,7 @@ errr process_pref_file_command(char* buf)
                 f_ptr->x_attr = (byte)n1;
             if (n2)
                 f_ptr->x_char = (char)n2;
+            wipe_map_memo();
             return (0);
         }
     }
@@ -170,6 +170,15 @@ static dun_data* dun;
 int cave_corridor1[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
 int cave_corridor2[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
 
+/*
+ * Note that the level being built is to be thrown away, and why
+ */
+static void gen_fail(int why)
+{
+    gen_fail_last[why]++;
+    gen_fail_total[why]++;
+}
+
 /* determines whether the player can pass through a given feature */
 /* icky locations (inside vaults) are all considered passable.    */
 bool player_passable(int y, int x, bool ignore_rubble_and_chasms)
@@ -193,43 +202,81 @@ bool player_passable(int y, int x, bool ignore_rubble_and_chasms)
     }
 }
 
-/* floodfills access through the dungeon, marking all accessible squares with
- * true */
-void flood_access(int y, int x,
-    int access_array[MAX_DUNGEON_HGT][MAX_DUNGEON_WID],
-    bool ignore_rubble_and_chasms)
+/*
+ * Flags for "check_connectivity()", kept in one byte per grid
+ */
+#define ACCESS_LOOSE 0x01 /* Passable if rubble and chasms are ignored */
+#define ACCESS_STRICT 0x02 /* Passable without rubble or chasms */
+#define ACCESS_DOWN 0x04 /* A down staircase or shaft */
+#define ACCESS_REACHED 0x08 /* Reached by the current flood */
+
+static byte cave_access[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+
+/*
+ * Queue of grids for "flood_access()"
+ */
+static u16b access_queue[MAX_DUNGEON_HGT * MAX_DUNGEON_WID];
+
+/*
+ * Floodfills access through the dungeon from (y,x) over the grids with the
+ * "pass" flag, counting the passable grids reached in "reached" and
+ * stopping early if a grid with the "goal" flag is found (returns true).
+ *
+ * This uses a queue rather than recursion, which could go thousands of
+ * calls deep on open levels.
+ */
+static bool flood_access(int y, int x, byte pass, byte goal, int* reached)
 {
+    int head = 0;
+    int tail = 0;
+    int i, j;
+
+    *reached = 0;
+
     /* first check the map bounds */
-    if ((y < 0) || (y > p_ptr->cur_map_hgt) || (x < 0)
-        || (x > p_ptr->cur_map_wid))
-        return;
+    if (!in_bounds(y, x))
+        return (false);
 
-    access_array[y][x] = true;
-    if (player_passable(y - 1, x - 1, ignore_rubble_and_chasms)
-        && (access_array[y - 1][x - 1] == false))
-        flood_access(y - 1, x - 1, access_array, ignore_rubble_and_chasms);
-    if (player_passable(y - 1, x, ignore_rubble_and_chasms)
-        && (access_array[y - 1][x] == false))
-        flood_access(y - 1, x, access_array, ignore_rubble_and_chasms);
-    if (player_passable(y - 1, x + 1, ignore_rubble_and_chasms)
-        && (access_array[y - 1][x + 1] == false))
-        flood_access(y - 1, x + 1, access_array, ignore_rubble_and_chasms);
-    if (player_passable(y, x - 1, ignore_rubble_and_chasms)
-        && (access_array[y][x - 1] == false))
-        flood_access(y, x - 1, access_array, ignore_rubble_and_chasms);
-    if (player_passable(y, x + 1, ignore_rubble_and_chasms)
-        && (access_array[y][x + 1] == false))
-        flood_access(y, x + 1, access_array, ignore_rubble_and_chasms);
-    if (player_passable(y + 1, x - 1, ignore_rubble_and_chasms)
-        && (access_array[y + 1][x - 1] == false))
-        flood_access(y + 1, x - 1, access_array, ignore_rubble_and_chasms);
-    if (player_passable(y + 1, x, ignore_rubble_and_chasms)
-        && (access_array[y + 1][x] == false))
-        flood_access(y + 1, x, access_array, ignore_rubble_and_chasms);
-    if (player_passable(y + 1, x + 1, ignore_rubble_and_chasms)
-        && (access_array[y + 1][x + 1] == false))
-        flood_access(y + 1, x + 1, access_array, ignore_rubble_and_chasms);
-    return;
+    /* Forget the last flood */
+    for (i = 0; i < p_ptr->cur_map_hgt; i++)
+        for (j = 0; j < p_ptr->cur_map_wid; j++)
+            cave_access[i][j] &= ~(ACCESS_REACHED);
+
+    cave_access[y][x] |= (ACCESS_REACHED);
+    access_queue[tail++] = GRID(y, x);
+
+    while (head < tail)
+    {
+        int d;
+
+        y = GRID_Y(access_queue[head]);
+        x = GRID_X(access_queue[head]);
+        head++;
+
+        if (cave_access[y][x] & (pass))
+            (*reached)++;
+
+        if (cave_access[y][x] & (goal))
+            return (true);
+
+        for (d = 0; d < 8; d++)
+        {
+            int yy = y + ddy_ddd[d];
+            int xx = x + ddx_ddd[d];
+
+            if (!in_bounds(yy, xx))
+                continue;
+
+            if ((cave_access[yy][xx] & (pass))
+                && !(cave_access[yy][xx] & (ACCESS_REACHED)))
+            {
+                cave_access[yy][xx] |= (ACCESS_REACHED);
+                access_queue[tail++] = GRID(yy, xx);
+            }
+        }
+    }
+
+    return (false);
 }
 
 void label_rooms(void)
@@ -1798,27 +1845,42 @@ static bool place_rubble_player(void)
 
 bool check_connectivity(void)
 {
-    int cave_access[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
     int y, x;
+    int loose = 0;
+    int reached;
 
-    // Reset the array used for checking connectivity
+    // Work out both kinds of passability for every grid in one sweep
     for (y = 0; y < p_ptr->cur_map_hgt; y++)
+    {
         for (x = 0; x < p_ptr->cur_map_wid; x++)
-            cave_access[y][x] = false;
+        {
+            byte flags = 0;
 
-    // Make sure entire dungeon is connected (ignoring rubble and chasms)
-    flood_access(p_ptr->py, p_ptr->px, cave_access, true);
-    for (y = 0; y < p_ptr->cur_map_hgt; y++)
-        for (x = 0; x < p_ptr->cur_map_wid; x++)
-            if (player_passable(y, x, true) && (cave_access[y][x] == false))
+            // The outer walls are never passable (and player_passable()
+            // would look past them)
+            if (in_bounds_fully(y, x))
             {
-                return (false);
+                if (player_passable(y, x, true))
+                {
+                    flags |= (ACCESS_LOOSE);
+                    loose++;
+                }
+                if (player_passable(y, x, false))
+                    flags |= (ACCESS_STRICT);
             }
 
-    // Reset the array used for checking connectivity
-    for (y = 0; y < p_ptr->cur_map_hgt; y++)
-        for (x = 0; x < p_ptr->cur_map_wid; x++)
-            cave_access[y][x] = false;
+            if ((cave_feat[y][x] == FEAT_MORE)
+                || (cave_feat[y][x] == FEAT_MORE_SHAFT))
+                flags |= (ACCESS_DOWN);
+
+            cave_access[y][x] = flags;
+        }
+    }
+
+    // Make sure entire dungeon is connected (ignoring rubble and chasms)
+    (void)flood_access(p_ptr->py, p_ptr->px, ACCESS_LOOSE, 0, &reached);
+    if (reached < loose)
+        return (false);
 
     if (p_ptr->create_stair == FEAT_MORE
         || p_ptr->create_stair == FEAT_MORE_SHAFT)
@@ -1828,19 +1890,8 @@ bool check_connectivity(void)
 
     // Make sure player can reach down stairs without going through rubble and
     // chasms
-    flood_access(p_ptr->py, p_ptr->px, cave_access, false);
-    for (y = 0; y < p_ptr->cur_map_hgt; y++)
-        for (x = 0; x < p_ptr->cur_map_wid; x++)
-        {
-            if (((cave_feat[y][x] == FEAT_MORE) && (cave_access[y][x] == true))
-                || ((cave_feat[y][x] == FEAT_MORE_SHAFT)
-                    && (cave_access[y][x] == true)))
-            {
-                return (true);
-            }
-        }
-
-    return (false);
+    return (flood_access(
+        p_ptr->py, p_ptr->px, ACCESS_STRICT, ACCESS_DOWN, &reached));
 }
 
 /*
@@ -1974,6 +2025,17 @@ static bool connect_rooms_stairs(void)
         pieces = dungeon_pieces();
     }
 
+    // give up now if the rooms are still in pieces, as the level would
+    // almost never pass "check_connectivity()" after all the work to come
+    if (pieces > 1)
+    {
+        if (cheat_room)
+            msg_format("Rooms left in %d pieces.", pieces);
+
+        gen_fail(GEN_FAIL_PIECES);
+        return (false);
+    }
+
     // label_rooms();
 
     /* Place down stairs */
@@ -2000,6 +2062,7 @@ static bool connect_rooms_stairs(void)
         if (cheat_room)
             msg_format("Failed to place down stairs.");
 
+        gen_fail(GEN_FAIL_STAIRS);
         return (false);
     }
 
@@ -2026,6 +2089,7 @@ static bool connect_rooms_stairs(void)
         if (cheat_room)
             msg_format("Failed to place up stairs.");
 
+        gen_fail(GEN_FAIL_STAIRS);
         return (false);
     }
 
@@ -2034,7 +2098,10 @@ static bool connect_rooms_stairs(void)
     {
         /*if we can't build streamers, something is wrong with level*/
         if (!build_streamer(FEAT_QUARTZ))
+        {
+            gen_fail(GEN_FAIL_STREAMER);
             return (false);
+        }
     }
 
     // add any chasms if needed
@@ -2376,9 +2443,13 @@ static bool build_vault(int y0, int x0, vault_type* v_ptr, bool flip_d)
 {
     int ymax = v_ptr->hgt;
     int xmax = v_ptr->wid;
-    cptr data = v_text + v_ptr->text;
-    int dx, dy, x, y;
-    int ax, ay;
+    const vault_layout* vl = &vault_layouts[v_ptr - v_info];
+    const vault_op* grids = &vault_ops[vl->start];
+    const vault_op* op;
+    const vault_op* op_end;
+    int x, y;
+    int ay0 = 0, ax0 = 0, sv = 1, sh = 1;
+    int yb, y_dy, y_dx, xb, x_dy, x_dx;
     bool flip_v = false;
     bool flip_h = false;
     int multiplier;
@@ -2388,26 +2459,12 @@ static bool build_vault(int y0, int x0, vault_type* v_ptr, bool flip_d)
 
     log_trace("build_vault: Building vault '%s' with color=%d", v_name + v_ptr->name, v_ptr->color);
 
-    cptr t;
-
     // Check that the vault doesn't contain invalid things for its depth
-    for (t = data, dy = 0; dy < ymax; dy++)
+    // (barrow wights deeper than level 15, chasms at 950 ft)
+    if (p_ptr->depth > vl->max_depth)
     {
-        for (dx = 0; dx < xmax; dx++, t++)
-        {
-            // Barrow wights can't be deeper than level 15
-            if ((*t == 'W') && (p_ptr->depth > 15))
-            {
-                log_debug("Skipped a barrow wight vault.");
-                return (false);
-            }
-
-            // chasms can't occur at 950 ft
-            if ((*t == '7') && (p_ptr->depth >= MORGOTH_DEPTH - 1))
-            {
-                return (false);
-            }
-        }
+        log_debug("Skipped vault '%s' (too deep for it).", v_name + v_ptr->name);
+        return (false);
     }
 
     // reflections
@@ -2422,6 +2479,41 @@ static bool build_vault(int y0, int x0, vault_type* v_ptr, bool flip_d)
             flip_h = true;
     }
 
+    /*
+     * Work out where each grid of the layout goes: flipping a vault just
+     * runs its rows or columns backwards, and flipping it diagonally swaps
+     * them over
+     */
+    if (flip_v)
+    {
+        ay0 = ymax - 1;
+        sv = -1;
+    }
+    if (flip_h)
+    {
+        ax0 = xmax - 1;
+        sh = -1;
+    }
+
+    if (flip_d)
+    {
+        yb = y0 - (xmax / 2) + ax0;
+        y_dy = 0;
+        y_dx = sh;
+        xb = x0 - (ymax / 2) + ay0;
+        x_dy = sv;
+        x_dx = 0;
+    }
+    else
+    {
+        yb = y0 - (ymax / 2) + ay0;
+        y_dy = sv;
+        y_dx = 0;
+        xb = x0 - (xmax / 2) + ax0;
+        x_dy = 0;
+        x_dx = sh;
+    }
+
     /* Begin the vault style context now that the vault is accepted */
     styles_begin_vault(-1, 0);
     /* If vault has explicit style list, use it (support '*'=-1); else apply per-depth default */
@@ -2455,154 +2547,122 @@ static bool build_vault(int y0, int x0, vault_type* v_ptr, bool flip_d)
     /* Place dungeon features and objects */
     int vault_primary_sidx_for_encoding = styles_get_vault_primary_style();
     int v_min_y = 32767, v_min_x = 32767, v_max_y = -32768, v_max_x = -32768; /* track vault bbox */
-    for (t = data, dy = 0; dy < ymax; dy++)
-    {
-        if (flip_v)
-            ay = ymax - 1 - dy;
-        else
-            ay = dy;
-
-        for (dx = 0; dx < xmax; dx++, t++)
-        {
-            if (flip_h)
-                ax = xmax - 1 - dx;
-            else
-                ax = dx;
-
-            /* Extract the location */
-            x = x0 - (xmax / 2) + ax;
-            y = y0 - (ymax / 2) + ay;
-
-            // diagonal flipping
-            if (flip_d)
-            {
-                x = x0 - (ymax / 2) + ay;
-                y = y0 - (xmax / 2) + ax;
-            }
-
-            /* Hack -- skip "non-grids" but still advance bbox only on placed tiles */
-            if (*t == ' ')
-                continue;
-
-            /* Track bbox of actual vault content */
-            if (y < v_min_y) v_min_y = y;
-            if (y > v_max_y) v_max_y = y;
-            if (x < v_min_x) v_min_x = x;
-            if (x > v_max_x) v_max_x = x;
-
-            /* Lay down a floor, encoding the vault style and forcing first variant */
-            if (vault_primary_sidx_for_encoding >= 0) {
-                int enc = COLOR_STYLE_BASE + COLOR_STYLE_FLAG_FIRSTVAR + (vault_primary_sidx_for_encoding & (COLOR_STYLE_SLOT_MAX - 1));
-                cave_set_feat_with_color(y, x, FEAT_FLOOR, enc);
-            } else {
-                cave_set_feat(y, x, FEAT_FLOOR);
-            }
-
-            /* Part of a vault */
-            cave_info[y][x] |= (CAVE_ROOM | CAVE_ICKY);
+    for (op = grids, op_end = grids + vl->num; op < op_end; op++)
+    {
+        /* Extract the location */
+        y = yb + y_dy * op->dy + y_dx * op->dx;
+        x = xb + x_dy * op->dy + x_dx * op->dx;
+
+        /* Track bbox of actual vault content */
+        if (y < v_min_y) v_min_y = y;
+        if (y > v_max_y) v_max_y = y;
+        if (x < v_min_x) v_min_x = x;
+        if (x > v_max_x) v_max_x = x;
+
+        /* Lay down a floor, encoding the vault style and forcing first variant */
+        if (vault_primary_sidx_for_encoding >= 0) {
+            int enc = COLOR_STYLE_BASE + COLOR_STYLE_FLAG_FIRSTVAR + (vault_primary_sidx_for_encoding & (COLOR_STYLE_SLOT_MAX - 1));
+            cave_set_feat_with_color(y, x, FEAT_FLOOR, enc);
+        } else {
+            cave_set_feat(y, x, FEAT_FLOOR);
+        }
 
-            /* Analyze the grid */
-            switch (*t)
-            {
-            /* Granite wall (outer) */
-            case '$':
-            {
-                cave_set_feat_with_color(y, x, FEAT_WALL_OUTER, 0);
-                break;
-            }
-            /* Granite wall (inner) */
-            case '#':
-            {
-                cave_set_feat_with_color(y, x, FEAT_WALL_INNER, 0);
-                break;
-            }
+        /* Part of a vault */
+        cave_info[y][x] |= (CAVE_ROOM | CAVE_ICKY);
 
-            /* Quartz vein */
-            case '%':
-            {
-                cave_set_feat_with_color(y, x, FEAT_QUARTZ, 0);
-                break;
-            }
+        /* Analyze the grid */
+        switch (op->c)
+        {
+        /* Granite wall (outer) */
+        case '$':
+        {
+            cave_set_feat_with_color(y, x, FEAT_WALL_OUTER, 0);
+            break;
+        }
+        /* Granite wall (inner) */
+        case '#':
+        {
+            cave_set_feat_with_color(y, x, FEAT_WALL_INNER, 0);
+            break;
+        }
 
-            /* Rubble */
-            case ':':
-            {
-                cave_set_feat_with_color(y, x, FEAT_RUBBLE, 0);
-                break;
-            }
+        /* Quartz vein */
+        case '%':
+        {
+            cave_set_feat_with_color(y, x, FEAT_QUARTZ, 0);
+            break;
+        }
 
-            /* Glyph of warding */
-            case ';':
-            {
-                cave_set_feat(y, x, FEAT_GLYPH);
-                break;
-            }
+        /* Rubble */
+        case ':':
+        {
+            cave_set_feat_with_color(y, x, FEAT_RUBBLE, 0);
+            break;
+        }
 
-                /* Down staircase */
-            case '>':
-            {
-                cave_set_feat(y, x, FEAT_MORE);
-                break;
-            }
+        /* Glyph of warding */
+        case ';':
+        {
+            cave_set_feat(y, x, FEAT_GLYPH);
+            break;
+        }
 
-            /* Up staircase */
-            case '<':
-            {
-                cave_set_feat(y, x, FEAT_LESS);
-                break;
-            }
+            /* Down staircase */
+        case '>':
+        {
+            cave_set_feat(y, x, FEAT_MORE);
+            break;
+        }
 
-            /* Visible door */
-            case '+':
-            {
-                place_closed_door(y, x);
-                break;
-            }
+        /* Up staircase */
+        case '<':
+        {
+            cave_set_feat(y, x, FEAT_LESS);
+            break;
+        }
 
-            /* Secret door */
-            case 's':
-            {
-                place_secret_door(y, x);
-                break;
-            }
+        /* Visible door */
+        case '+':
+        {
+            place_closed_door(y, x);
+            break;
+        }
 
-            /* Trap */
-            case '^':
-            {
-                if (one_in_(2))
-                    place_trap(y, x);
-                break;
-            }
+        /* Secret door */
+        case 's':
+        {
+            place_secret_door(y, x);
+            break;
+        }
 
-            /* Forge */
-            case '0':
-            {
-                place_forge(y, x);
-                break;
-            }
+        /* Trap */
+        case '^':
+        {
+            if (one_in_(2))
+                place_trap(y, x);
+            break;
+        }
 
-            /* Chasm */
-            case '7':
-            {
-                cave_set_feat(y, x, FEAT_CHASM);
-                break;
-            }
+        /* Forge */
+        case '0':
+        {
+            place_forge(y, x);
+            break;
+        }
 
-            /* Sunlight */
-            case ',':
-            {
-                cave_set_feat(y, x, FEAT_SUNLIGHT);
-                break;
-            }
+        /* Chasm */
+        case '7':
+        {
+            cave_set_feat(y, x, FEAT_CHASM);
+            break;
+        }
 
-            /* Not actually part of the vault after all */
-            case ' ':
-            {
-                // remove room and vault flags
-                cave_info[y][x] &= ~(CAVE_ROOM | CAVE_ICKY);
-                break;
-            }
-            }
+        /* Sunlight */
+        case ',':
+        {
+            cave_set_feat(y, x, FEAT_SUNLIGHT);
+            break;
+        }
         }
     }
 
@@ -2679,431 +2739,391 @@ static bool build_vault(int y0, int x0, vault_type* v_ptr, bool flip_d)
     styles_end_vault();
 
     /* Place dungeon monsters and objects */
-    for (t = data, dy = 0; dy < ymax; dy++)
+    for (op = grids + vl->num, op_end = op + vl->place; op < op_end; op++)
     {
-        if (flip_v)
-            ay = ymax - 1 - dy;
-        else
-            ay = dy;
+        /* Extract the grid */
+        y = yb + y_dy * op->dy + y_dx * op->dx;
+        x = xb + x_dy * op->dy + x_dx * op->dx;
+
+        /* Analyze the symbol */
+        switch (op->c)
+        {
+        /* A monster from 1 level deeper */
+        case '1':
+        {
+            monster_level = p_ptr->depth + 1;
+            place_monster(y, x, true, true, true);
+            monster_level = original_monster_level;
+            break;
+        }
+
+        /* A monster from 2 levels deeper */
+        case '2':
+        {
+            monster_level = p_ptr->depth + 2;
+            place_monster(y, x, true, true, true);
+            monster_level = original_monster_level;
+            break;
+        }
+
+        /* A monster from 3 levels deeper */
+        case '3':
+        {
+            monster_level = p_ptr->depth + 3;
+            place_monster(y, x, true, true, true);
+            monster_level = original_monster_level;
+            break;
+        }
+
+        /* A monster from 4 levels deeper */
+        case '4':
+        {
+            monster_level = p_ptr->depth + 4;
+            place_monster(y, x, true, true, true);
+            monster_level = original_monster_level;
+            break;
+        }
+
+        /* An object from 1-4 levels deeper */
+        case '*':
+        {
+            object_level = p_ptr->depth + dieroll(4);
+            place_object(y, x, false, false, DROP_TYPE_NOT_DAMAGED);
+            object_level = original_object_level;
+            break;
+        }
+
+        /* A good object from 1-4 levels deeper */
+        case '&':
+        {
+            object_level = p_ptr->depth + dieroll(4);
+            place_object(y, x, true, false, DROP_TYPE_NOT_DAMAGED);
+            object_level = original_object_level;
+            break;
+        }
 
-        for (dx = 0; dx < xmax; dx++, t++)
+        /* A chest from 4 levels deeper */
+        case '~':
         {
-            if (flip_h)
-                ax = xmax - 1 - dx;
+            if (p_ptr->depth == 0)
+                object_level = MORGOTH_DEPTH;
             else
-                ax = dx;
+                object_level = p_ptr->depth + 4;
+            ;
+
+            place_object(y, x, false, false, DROP_TYPE_CHEST);
+            object_level = original_object_level;
+            break;
+        }
 
-            /* Extract the grid */
-            x = x0 - (xmax / 2) + ax;
-            y = y0 - (ymax / 2) + ay;
+        /* A skeleton */
+        case 'S':
+        {
+            object_type* i_ptr;
+            object_type object_type_body;
+            s16b k_idx;
 
-            // diagonal flipping
-            if (flip_d)
+            // make a skeleton 1/2 of the time
+            if (one_in_(2))
             {
-                x = x0 - (ymax / 2) + ay;
-                y = y0 - (xmax / 2) + ax;
+                /* Get local object */
+                i_ptr = &object_type_body;
+
+                /* Wipe the object */
+                object_wipe(i_ptr);
+
+                if (one_in_(3))
+                    k_idx = lookup_kind(TV_SKELETON, SV_SKELETON_HUMAN);
+                else
+                    k_idx = lookup_kind(TV_SKELETON, SV_SKELETON_ELF);
+
+                /* Prepare the item */
+                object_prep(i_ptr, k_idx);
+
+                i_ptr->pval = 1;
+
+                /* Drop it in the dungeon */
+                drop_near(i_ptr, -1, y, x);
             }
+            break;
+        }
 
-            /* Hack -- skip "non-grids" */
-            if (*t == ' ')
-                continue;
+        /* Monster and/or object from 1 level deeper */
+        case '?':
+        {
+            int r = dieroll(3);
 
-            /* Analyze the symbol */
-            switch (*t)
-            {
-            /* A monster from 1 level deeper */
-            case '1':
+            if (r <= 2)
             {
                 monster_level = p_ptr->depth + 1;
                 place_monster(y, x, true, true, true);
                 monster_level = original_monster_level;
-                break;
             }
-
-            /* A monster from 2 levels deeper */
-            case '2':
+            if (r >= 2)
             {
-                monster_level = p_ptr->depth + 2;
-                place_monster(y, x, true, true, true);
-                monster_level = original_monster_level;
-                break;
+                object_level = p_ptr->depth + 1;
+                place_object(y, x, false, false, DROP_TYPE_UNTHEMED);
+                object_level = original_object_level;
             }
+            break;
+        }
 
-            /* A monster from 3 levels deeper */
-            case '3':
-            {
-                monster_level = p_ptr->depth + 3;
-                place_monster(y, x, true, true, true);
-                monster_level = original_monster_level;
-                break;
-            }
-
-            /* A monster from 4 levels deeper */
-            case '4':
-            {
-                monster_level = p_ptr->depth + 4;
-                place_monster(y, x, true, true, true);
-                monster_level = original_monster_level;
-                break;
-            }
-
-            /* An object from 1-4 levels deeper */
-            case '*':
-            {
-                object_level = p_ptr->depth + dieroll(4);
-                place_object(y, x, false, false, DROP_TYPE_NOT_DAMAGED);
-                object_level = original_object_level;
-                break;
-            }
-
-            /* A good object from 1-4 levels deeper */
-            case '&':
-            {
-                object_level = p_ptr->depth + dieroll(4);
-                place_object(y, x, true, false, DROP_TYPE_NOT_DAMAGED);
-                object_level = original_object_level;
-                break;
-            }
-
-            /* A chest from 4 levels deeper */
-            case '~':
-            {
-                if (p_ptr->depth == 0)
-                    object_level = MORGOTH_DEPTH;
-                else
-                    object_level = p_ptr->depth + 4;
-                ;
-
-                place_object(y, x, false, false, DROP_TYPE_CHEST);
-                object_level = original_object_level;
-                break;
-            }
-
-            /* A skeleton */
-            case 'S':
-            {
-                object_type* i_ptr;
-                object_type object_type_body;
-                s16b k_idx;
-
-                // make a skeleton 1/2 of the time
-                if (one_in_(2))
-                {
-                    /* Get local object */
-                    i_ptr = &object_type_body;
+        /* Carcharoth */
+        case 'C':
+        {
+            place_monster_one(y, x, R_IDX_CARCHAROTH, true, true, NULL);
+            break;
+        }
 
-                    /* Wipe the object */
-                    object_wipe(i_ptr);
+        /* silent watcher */
+        case 'H':
+        {
+            place_monster_one(
+                y, x, R_IDX_SILENT_WATCHER, true, false, NULL);
+            break;
+        }
 
-                    if (one_in_(3))
-                        k_idx = lookup_kind(TV_SKELETON, SV_SKELETON_HUMAN);
-                    else
-                        k_idx = lookup_kind(TV_SKELETON, SV_SKELETON_ELF);
+        /* easterling spy */
+        case '@':
+        {
+            place_monster_one(
+                y, x, R_IDX_EASTERLING_SPY, true, false, NULL);
+            break;
+        }
 
-                    /* Prepare the item */
-                    object_prep(i_ptr, k_idx);
+        /* orc champion */
+        case 'o':
+        {
+            place_monster_one(y, x, R_IDX_ORC_CHAMPION, true, false, NULL);
+            break;
+        }
 
-                    i_ptr->pval = 1;
+        /* orc captain */
+        case 'O':
+        {
+            place_monster_one(y, x, R_IDX_ORC_CAPTAIN, true, false, NULL);
+            break;
+        }
 
-                    /* Drop it in the dungeon */
-                    drop_near(i_ptr, -1, y, x);
-                }
-                break;
-            }
+        case 'z':
+        {
+            int humanOrElf
+                = one_in_(2) ? R_IDX_HUMAN_THRALL : R_IDX_ELF_THRALL;
 
-            /* Monster and/or object from 1 level deeper */
-            case '?':
+            if (p_ptr->thrall_quest == QUEST_NOT_STARTED)
             {
-                int r = dieroll(3);
-
-                if (r <= 2)
-                {
-                    monster_level = p_ptr->depth + 1;
-                    place_monster(y, x, true, true, true);
-                    monster_level = original_monster_level;
-                }
-                if (r >= 2)
+                if (one_in_(8))
                 {
-                    object_level = p_ptr->depth + 1;
-                    place_object(y, x, false, false, DROP_TYPE_UNTHEMED);
-                    object_level = original_object_level;
+                    humanOrElf = one_in_(2) ?
+                                R_IDX_ALERT_HUMAN_THRALL :
+                                R_IDX_ALERT_ELF_THRALL;
+                    p_ptr->thrall_quest = QUEST_GIVER_PRESENT; 
                 }
-                break;
             }
 
-            /* Carcharoth */
-            case 'C':
-            {
-                place_monster_one(y, x, R_IDX_CARCHAROTH, true, true, NULL);
-                break;
-            }
-
-            /* silent watcher */
-            case 'H':
-            {
-                place_monster_one(
-                    y, x, R_IDX_SILENT_WATCHER, true, false, NULL);
-                break;
-            }
-
-            /* easterling spy */
-            case '@':
-            {
-                place_monster_one(
-                    y, x, R_IDX_EASTERLING_SPY, true, false, NULL);
-                break;
-            }
-
-            /* orc champion */
-            case 'o':
-            {
-                place_monster_one(y, x, R_IDX_ORC_CHAMPION, true, false, NULL);
-                break;
-            }
-
-            /* orc captain */
-            case 'O':
-            {
-                place_monster_one(y, x, R_IDX_ORC_CAPTAIN, true, false, NULL);
-                break;
-            }
-
-            case 'z':
-            {
-                int humanOrElf
-                    = one_in_(2) ? R_IDX_HUMAN_THRALL : R_IDX_ELF_THRALL;
-
-                if (p_ptr->thrall_quest == QUEST_NOT_STARTED)
-                {
-                    if (one_in_(8))
-                    {
-                        humanOrElf = one_in_(2) ?
-                                    R_IDX_ALERT_HUMAN_THRALL :
-                                    R_IDX_ALERT_ELF_THRALL;
-                        p_ptr->thrall_quest = QUEST_GIVER_PRESENT; 
-                    }
-                }
-
-                place_monster_one(y, x, humanOrElf, true, true, NULL);
-                break;
-            }
+            place_monster_one(y, x, humanOrElf, true, true, NULL);
+            break;
+        }
 
-            case 'Z':
-            {
-                place_monster_one(
-                    y, x, R_IDX_ORC_THRALLMASTER, true, true, NULL);
-                break;
-            }
+        case 'Z':
+        {
+            place_monster_one(
+                y, x, R_IDX_ORC_THRALLMASTER, true, true, NULL);
+            break;
+        }
 
-            /* cat warrior */
-            case 'f':
-            {
-                place_monster_one(y, x, R_IDX_CAT_WARRIOR, true, false, NULL);
-                break;
-            }
+        /* cat warrior */
+        case 'f':
+        {
+            place_monster_one(y, x, R_IDX_CAT_WARRIOR, true, false, NULL);
+            break;
+        }
 
-            /* cat assassin */
-            case 'F':
-            {
-                place_monster_one(y, x, R_IDX_CAT_ASSASSIN, true, false, NULL);
-                break;
-            }
+        /* cat assassin */
+        case 'F':
+        {
+            place_monster_one(y, x, R_IDX_CAT_ASSASSIN, true, false, NULL);
+            break;
+        }
 
-            /* troll guard */
-            case 'T':
-            {
-                place_monster_one(y, x, R_IDX_TROLL_GUARD, true, false, NULL);
-                break;
-            }
+        /* troll guard */
+        case 'T':
+        {
+            place_monster_one(y, x, R_IDX_TROLL_GUARD, true, false, NULL);
+            break;
+        }
 
-            /* barrow wight */
-            case 'W':
-            {
-                place_monster_one(y, x, R_IDX_BARROW_WIGHT, true, true, NULL);
-                break;
-            }
+        /* barrow wight */
+        case 'W':
+        {
+            place_monster_one(y, x, R_IDX_BARROW_WIGHT, true, true, NULL);
+            break;
+        }
 
-            /* dragon */
-            case 'd':
-            {
-                place_monster_by_flag(
-                    y, x, 3, RF3_DRAGON, true, p_ptr->depth + 4);
-                break;
-            }
+        /* dragon */
+        case 'd':
+        {
+            place_monster_by_flag(
+                y, x, 3, RF3_DRAGON, true, p_ptr->depth + 4);
+            break;
+        }
 
-            /* young cold drake */
-            case 'y':
-            {
-                place_monster_one(
-                    y, x, R_IDX_YOUNG_COLD_DRAKE, true, false, NULL);
-                break;
-            }
+        /* young cold drake */
+        case 'y':
+        {
+            place_monster_one(
+                y, x, R_IDX_YOUNG_COLD_DRAKE, true, false, NULL);
+            break;
+        }
 
-            /* young fire drake */
-            case 'Y':
-            {
-                place_monster_one(
-                    y, x, R_IDX_YOUNG_FIRE_DRAKE, true, false, NULL);
-                break;
-            }
+        /* young fire drake */
+        case 'Y':
+        {
+            place_monster_one(
+                y, x, R_IDX_YOUNG_FIRE_DRAKE, true, false, NULL);
+            break;
+        }
 
-            /* Spider */
-            case 'M':
-            {
-                place_monster_by_flag(
-                    y, x, 3, RF3_SPIDER, true, p_ptr->depth + rand_range(1, 4));
-                break;
-            }
+        /* Spider */
+        case 'M':
+        {
+            place_monster_by_flag(
+                y, x, 3, RF3_SPIDER, true, p_ptr->depth + rand_range(1, 4));
+            break;
+        }
 
-            /* Vampire */
-            case 'v':
-            {
-                place_monster_by_letter(
-                    y, x, 'v', true, p_ptr->depth + rand_range(1, 4));
-                break;
-            }
+        /* Vampire */
+        case 'v':
+        {
+            place_monster_by_letter(
+                y, x, 'v', true, p_ptr->depth + rand_range(1, 4));
+            break;
+        }
 
-                /* Archer */
-            case 'a':
-            {
-                place_monster_by_flag(
-                    y, x, 4, (RF4_ARROW1 | RF4_ARROW2), true, p_ptr->depth + 1);
-                break;
-            }
+            /* Archer */
+        case 'a':
+        {
+            place_monster_by_flag(
+                y, x, 4, (RF4_ARROW1 | RF4_ARROW2), true, p_ptr->depth + 1);
+            break;
+        }
 
-                /* Flier */
-            case 'b':
-            {
-                place_monster_by_flag(
-                    y, x, 2, (RF2_FLYING), true, p_ptr->depth + 1);
-                break;
-            }
+            /* Flier */
+        case 'b':
+        {
+            place_monster_by_flag(
+                y, x, 2, (RF2_FLYING), true, p_ptr->depth + 1);
+            break;
+        }
 
-            /* Wolf */
-            case 'c':
-            {
-                place_monster_by_flag(
-                    y, x, 3, RF3_WOLF, true, p_ptr->depth + rand_range(1, 4));
-                break;
-            }
+        /* Wolf */
+        case 'c':
+        {
+            place_monster_by_flag(
+                y, x, 3, RF3_WOLF, true, p_ptr->depth + rand_range(1, 4));
+            break;
+        }
 
-            /* Rauko */
-            case 'r':
-            {
-                place_monster_by_flag(
-                    y, x, 3, RF3_RAUKO, true, p_ptr->depth + rand_range(1, 4));
-                break;
-            }
+        /* Rauko */
+        case 'r':
+        {
+            place_monster_by_flag(
+                y, x, 3, RF3_RAUKO, true, p_ptr->depth + rand_range(1, 4));
+            break;
+        }
 
-                /* Aldor */
-            case 'A':
-            {
-                place_monster_one(y, x, R_IDX_ALDOR, true, true, NULL);
-                break;
-            }
+            /* Aldor */
+        case 'A':
+        {
+            place_monster_one(y, x, R_IDX_ALDOR, true, true, NULL);
+            break;
+        }
 
-            /* Glaurung */
-            case 'D':
-            {
-                place_monster_one(y, x, R_IDX_GLAURUNG, true, true, NULL);
-                break;
-            }
+        /* Glaurung */
+        case 'D':
+        {
+            place_monster_one(y, x, R_IDX_GLAURUNG, true, true, NULL);
+            break;
+        }
 
-            /* Gothmog */
-            case 'R':
-            {
-                place_monster_one(y, x, R_IDX_GOTHMOG, true, true, NULL);
-                break;
-            }
+        /* Gothmog */
+        case 'R':
+        {
+            place_monster_one(y, x, R_IDX_GOTHMOG, true, true, NULL);
+            break;
+        }
 
-            /* Ungoliant */
-            case 'U':
-            {
-                place_monster_one(y, x, R_IDX_UNGOLIANT, true, true, NULL);
-                break;
-            }
+        /* Ungoliant */
+        case 'U':
+        {
+            place_monster_one(y, x, R_IDX_UNGOLIANT, true, true, NULL);
+            break;
+        }
 
-            /* Gorthaur */
-            case 'G':
-            {
-                place_monster_one(y, x, R_IDX_GORTHAUR, true, true, NULL);
-                break;
-            }
+        /* Gorthaur */
+        case 'G':
+        {
+            place_monster_one(y, x, R_IDX_GORTHAUR, true, true, NULL);
+            break;
+        }
 
-            /* Morgoth */
-            case 'V':
-            {
-                place_monster_one(y, x, R_IDX_MORGOTH, true, true, NULL);
-                break;
-            }
-            }
+        /* Morgoth */
+        case 'V':
+        {
+            place_monster_one(y, x, R_IDX_MORGOTH, true, true, NULL);
+            break;
+        }
         }
     }
 
-    /* Place dungeon features and objects */
-    for (t = data, dy = 0; dy < ymax; dy++)
+    /* Light the vault and add traps */
+    for (op = grids, op_end = grids + vl->num; op < op_end; op++)
     {
-        if (flip_v)
-            ay = ymax - 1 - dy;
-        else
-            ay = dy;
+        /* Extract the location */
+        y = yb + y_dy * op->dy + y_dx * op->dx;
+        x = xb + x_dy * op->dy + x_dx * op->dx;
 
-        for (dx = 0; dx < xmax; dx++, t++)
+        // some vaults are always lit
+        if (v_ptr->flags & (VLT_LIGHT))
         {
-            if (flip_h)
-                ax = xmax - 1 - dx;
-            else
-                ax = dx;
-
-            /* Extract the location */
-            x = x0 - (xmax / 2) + ax;
-            y = y0 - (ymax / 2) + ay;
-
-            // diagonal flipping
-            if (flip_d)
-            {
-                x = x0 - (ymax / 2) + ay;
-                y = y0 - (xmax / 2) + ax;
-            }
+            cave_info[y][x] |= (CAVE_GLOW);
+        }
 
-            /* Hack -- skip "non-grids" */
-            if (*t == ' ')
-                continue;
+        // traps are usually 5 times as likely in vaults, but are 10 times
+        // as likely if the TRAPS flag is set
+        multiplier = (v_ptr->flags & (VLT_TRAPS)) ? 10 : 5;
 
-            // some vaults are always lit
-            if (v_ptr->flags & (VLT_LIGHT))
+        // another chance to place traps, with 4 times the normal chance
+        // so traps in interesting rooms and vaults are a total of 5 times
+        // more likely webbed vaults also have a large chance of receiving
+        // webs
+        if ((v_ptr->flags & (VLT_WEBS)))
+        {
+            if (cave_naked_bold(y, x) && one_in_(20))
             {
-                cave_info[y][x] |= (CAVE_GLOW);
-            }
-
-            // traps are usually 5 times as likely in vaults, but are 10 times
-            // as likely if the TRAPS flag is set
-            multiplier = (v_ptr->flags & (VLT_TRAPS)) ? 10 : 5;
+                /* Place a web trap */
+                cave_set_feat(y, x, FEAT_TRAP_WEB);
 
-            // another chance to place traps, with 4 times the normal chance
-            // so traps in interesting rooms and vaults are a total of 5 times
-            // more likely webbed vaults also have a large chance of receiving
-            // webs
-            if ((v_ptr->flags & (VLT_WEBS)))
-            {
-                if (cave_naked_bold(y, x) && one_in_(20))
+                // Hide it half the time
+                if (one_in_(2))
                 {
-                    /* Place a web trap */
-                    cave_set_feat(y, x, FEAT_TRAP_WEB);
-
-                    // Hide it half the time
-                    if (one_in_(2))
-                    {
-                        cave_info[y][x] |= (CAVE_HIDDEN);
-                    }
+                    cave_info[y][x] |= (CAVE_HIDDEN);
                 }
             }
-            else if (dieroll(1000)
-                <= trap_placement_chance(y, x) * (multiplier - 1))
-            {
-                place_trap(y, x);
-            }
         }
+        else if (dieroll(1000)
+            <= trap_placement_chance(y, x) * (multiplier - 1))
+        {
+            place_trap(y, x);
+        }
+    }
+
+    /* Note the vault */
+    if (gen_vault_n < GEN_VAULT_MAX)
+    {
+        gen_vault_y[gen_vault_n] = (byte)y0;
+        gen_vault_x[gen_vault_n] = (byte)x0;
+        gen_vault_idx[gen_vault_n++] = (s16b)(v_ptr - v_info);
     }
 
     return (true);
@@ -3175,96 +3195,105 @@ static bool place_room(int y0, int x0, vault_type* v_ptr)
 }
 
 /*
- * Type 6 -- least vaults (see "vault.txt")
+ * Pick a vault of type "typ" for the current depth from the vault index
+ * (see "init_alloc()"), returning its index, or zero if there is none.
+ *
+ * Only vaults with a forge are considered if "pick" has VAULT_PICK_FORGE.
+ * Vaults marked TEST are preferred, if there are any, when it has
+ * VAULT_PICK_TEST.
  */
-static bool build_type6(int y0, int x0, bool force_forge)
+static int pick_vault(int typ, int pick)
 {
-    vault_type* v_ptr;
-    int tries = 0;
+    int depth = MIN(MAX(p_ptr->depth, 0), MORGOTH_DEPTH);
+    vault_index* vi = &alloc_vault_index[VAULT_INDEX(typ, depth, pick)];
+    u32b* total;
+    u32b r;
+    int lo, hi;
 
-    /* Pick an interesting room */
-    while (true)
+    /* No vaults marked TEST */
+    if (!vi->num && (pick & (VAULT_PICK_TEST)))
     {
-        unsigned long long rarity = 0;
-        tries++;
-
-        /* Get a random vault record */
-        v_ptr = &v_info[rand_int(z_info->v_max)];
+        pick &= ~(VAULT_PICK_TEST);
+        vi = &alloc_vault_index[VAULT_INDEX(typ, depth, pick)];
+    }
 
-        // if forcing a forge, then skip vaults without forges in them
-        if (force_forge && !v_ptr->forge)
-            continue;
+    /* Nothing suitable */
+    if (!vi->num)
+        return (0);
 
-        // unless forcing a forge, try additional times to place any vault
-        // marked TEST
-        if ((tries < 1000) && !(v_ptr->flags & (VLT_TEST))
-            && !p_ptr->force_forge)
-            continue;
+    total = &alloc_vault_total[vi->start];
 
-        rarity = v_ptr->rarity;
-        if (p_ptr->depth < 6)
-        {
-            /* Surface rooms are more common at low depths */
-            if (!(v_ptr->flags & (VLT_SURFACE)) && !one_in_(4))
-                continue;
-        }
-        else if (v_ptr->flags & (VLT_SURFACE))
-        {
-            /* Surface rooms get very much rarer at depth */
-            rarity += (1 << (p_ptr->depth));
-        }
+    /* Pick a point in the total weight */
+    r = Rand_div(total[vi->num - 1]);
 
-        /* Accept the first interesting room */
-        if ((v_ptr->typ == 6) && (v_ptr->depth <= p_ptr->depth)
-            && (one_in_(rarity)))
-            break;
+    /* Find the candidate it falls to */
+    lo = 0;
+    hi = vi->num - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
 
-        if (tries > 20000)
-        {
-            if (!DEPLOYMENT || cheat_room)
-                msg_format(
-                    "Bug: Could not find a record for an Interesting Room in "
-                    "vault.txt");
-            return (false);
-        }
+        if (total[mid] > r)
+            hi = mid;
+        else
+            lo = mid + 1;
     }
 
-    return place_room(y0, x0, v_ptr);
+    return (alloc_vault_table[vi->start + lo]);
 }
 
 /*
- * Type 7 -- lesser vaults (see "vault.txt")
+ * Type 6 -- least vaults (see "vault.txt")
  */
-static bool build_type7(int y0, int x0)
+static bool build_type6(int y0, int x0, bool force_forge)
 {
     vault_type* v_ptr;
-    int tries = 0;
+    int pick = 0;
+    int v_idx;
 
-    /* Pick a lesser vault */
-    while (true)
+    // if forcing a forge, then skip vaults without forges in them
+    if (force_forge)
+        pick |= VAULT_PICK_FORGE;
+
+    // unless forcing a forge, prefer any vault marked TEST
+    if (!p_ptr->force_forge)
+        pick |= VAULT_PICK_TEST;
+
+    /* Pick an interesting room */
+    v_idx = pick_vault(6, pick);
+    if (!v_idx)
     {
-        tries++;
+        if (!DEPLOYMENT || cheat_room)
+            msg_format(
+                "Bug: Could not find a record for an Interesting Room in "
+                "vault.txt");
+        return (false);
+    }
 
-        /* Get a random vault record */
-        v_ptr = &v_info[rand_int(z_info->v_max)];
+    v_ptr = &v_info[v_idx];
 
-        // try additional times to place any vault marked TEST
-        if ((tries < 1000) && !(v_ptr->flags & (VLT_TEST)))
-            continue;
+    return place_room(y0, x0, v_ptr);
+}
 
-        /* Accept the first lesser vault */
-        if ((v_ptr->typ == 7) && (v_ptr->depth <= p_ptr->depth)
-            && (one_in_(v_ptr->rarity)))
-            break;
+/*
+ * Type 7 -- lesser vaults (see "vault.txt")
+ */
+static bool build_type7(int y0, int x0)
+{
+    vault_type* v_ptr;
+    int v_idx;
 
-        if (tries > 2000)
-        {
-            msg_format(
-                "Bug: Could not find a record for a Lesser Vault in vault.txt");
-            return (false);
-        }
+    /* Pick a lesser vault, preferring any marked TEST */
+    v_idx = pick_vault(7, VAULT_PICK_TEST);
+    if (!v_idx)
+    {
+        msg_format(
+            "Bug: Could not find a record for a Lesser Vault in vault.txt");
+        return (false);
     }
 
+    v_ptr = &v_info[v_idx];
+
     if (!place_room(y0, x0, v_ptr))
         return false;
     /* Message */
@@ -3318,37 +3347,31 @@ static bool build_type8(int y0, int x0)
         return (false);
     }
 
-    /* Pick a greater vault */
+    /* Pick a greater vault, preferring any marked TEST */
     while (!found)
     {
         tries++;
 
-        /* Get a random vault record */
-        v_idx = rand_int(z_info->v_max);
-        v_ptr = &v_info[v_idx];
+        v_idx = pick_vault(8, (tries < 50) ? VAULT_PICK_TEST : 0);
+        if (!v_idx)
+            return (false);
 
-        // try additional times to place any vault marked TEST
-        if ((tries < 1000) && !(v_ptr->flags & (VLT_TEST)))
-            continue;
+        v_ptr = &v_info[v_idx];
 
-        /* Accept the first greater vault */
-        if ((v_ptr->typ == 8) && (v_ptr->depth <= p_ptr->depth)
-            && (one_in_(v_ptr->rarity)))
+        /* Accept the first greater vault we have not seen before */
+        repeated = false;
+        for (i = 0; i < MAX_GREATER_VAULTS; i++)
         {
-            repeated = false;
-            for (i = 0; i < MAX_GREATER_VAULTS; i++)
+            if (v_idx == p_ptr->greater_vaults[i])
             {
-                if (v_idx == p_ptr->greater_vaults[i])
-                {
-                    repeated = true;
-                }
+                repeated = true;
             }
-
-            if (!repeated)
-                found = true;
         }
 
-        if (tries > 2000)
+        if (!repeated)
+            found = true;
+
+        if (tries > 100)
         {
             // if (!repeated) msg_debug("Bug: Could not find a record for a
             // Greater Vault in vault.txt");
@@ -3387,27 +3410,18 @@ static bool build_type8(int y0, int x0)
 static bool build_type9(int y0, int x0)
 {
     vault_type* v_ptr;
-    int tries = 0;
+    int v_idx;
 
     /* Pick a version of Morgoth's vault */
-    while (true)
+    v_idx = pick_vault(9, 0);
+    if (!v_idx)
     {
-        /* Get a random vault record */
-        v_ptr = &v_info[rand_int(z_info->v_max)];
-
-        /* Accept the first morgoth vault */
-        if (v_ptr->typ == 9)
-            break;
-
-        tries++;
-        if (tries > 10000)
-        {
-            msg_format(
-                "Could not find a record for Morgoth's Vault in vault.txt");
-            return (false);
-        }
+        msg_format("Could not find a record for Morgoth's Vault in vault.txt");
+        return (false);
     }
 
+    v_ptr = &v_info[v_idx];
+
     /* Try building the vault */
     if (!build_vault(y0, x0, v_ptr, false))
     {
@@ -3730,6 +3744,7 @@ static bool cave_gen(void)
         {
             if (cheat_room)
                 msg_format("failed.");
+            gen_fail(GEN_FAIL_FORGE);
 
             p_ptr->fixed_forge_count--;
             return (false);
@@ -3782,12 +3797,21 @@ static bool cave_gen(void)
     /*set the permanent walls*/
     set_perm_boundry();
 
+    /* Note the rooms */
+    gen_rooms = MIN(dun->cent_n, DUN_ROOMS);
+    for (i = 0; i < gen_rooms; i++)
+    {
+        gen_room_y[i] = dun->cent[i].y;
+        gen_room_x[i] = dun->cent[i].x;
+    }
+
     /*start over on all levels with less than two rooms due to inevitable
      * crash*/
     if (dun->cent_n < ROOM_MIN)
     {
         if (cheat_room)
             msg_format("Not enough rooms.");
+        gen_fail(GEN_FAIL_ROOMS);
         if (p_ptr->force_forge)
             p_ptr->fixed_forge_count--;
         return (false);
@@ -3823,6 +3847,7 @@ static bool cave_gen(void)
     {
         if (cheat_room)
             msg_format("Couldn't place, rubble, or player.");
+        gen_fail(GEN_FAIL_PLAYER);
         if (p_ptr->force_forge)
             p_ptr->fixed_forge_count--;
         return (false);
@@ -3854,6 +3879,7 @@ static bool cave_gen(void)
     {
         if (cheat_room)
             msg_format("Failed connectivity.");
+        gen_fail(GEN_FAIL_ACCESS);
         if (p_ptr->force_forge)
             p_ptr->fixed_forge_count--;
         return (false);
@@ -4115,17 +4141,104 @@ void unring_a_bell(void)
     }
 }
 
+/*
+ * Mix "v" into the hash "h"
+ */
+static u32b level_seed_mix(u32b h, u32b v)
+{
+    h ^= v;
+    h ^= h >> 16;
+    h *= 0x45D9F3BL;
+    h ^= h >> 16;
+    h *= 0x45D9F3BL;
+    h ^= h >> 16;
+
+    return (h);
+}
+
+/*
+ * The seed for the level the player is entering.
+ *
+ * It depends only on the game (through the seeds chosen at birth), the
+ * depth, the number of staircases taken and the number of levels generated
+ * before it, so the level is the same however many random numbers were
+ * drawn before it was generated.  The last of these changes however the
+ * player got here (a trapdoor, a chasm, digging, or deep descent), so a
+ * level left and entered again is a new one.
+ */
+static u32b level_seed(void)
+{
+    u32b h = 0;
+
+    h = level_seed_mix(h, seed_randart);
+    h = level_seed_mix(h, seed_flavor);
+    h = level_seed_mix(h, (u32b)p_ptr->depth);
+    h = level_seed_mix(h, (u32b)p_ptr->stairs_taken);
+    h = level_seed_mix(h, p_ptr->levels_generated);
+
+    return (h);
+}
+
+/*
+ * Describe a generated level as a key of the form "seed:depth:stairs:arrival"
+ * which "-l" and the wizard's level replay understand
+ */
+void gen_key(char* buf, size_t max, const gen_record* rec)
+{
+    strnfmt(buf, max, "%08lx:%d:%d:%d", (unsigned long)rec->seed,
+        (int)rec->depth, (int)rec->stairs_taken, (int)rec->create_stair);
+}
+
+/*
+ * Read a key made by "gen_key()", returning false if it is malformed
+ */
+bool gen_key_parse(cptr key, gen_record* rec)
+{
+    unsigned long seed;
+    int depth, stairs, arrival;
+
+    if (sscanf(key, "%lx:%d:%d:%d", &seed, &depth, &stairs, &arrival) != 4)
+        return (false);
+
+    if ((depth < 0) || (depth > MORGOTH_DEPTH) || (stairs < 0)
+        || (arrival < 0) || (arrival >= z_info->f_max))
+        return (false);
+
+    rec->seed = (u32b)seed;
+    rec->depth = (s16b)depth;
+    rec->stairs_taken = (u16b)stairs;
+    rec->create_stair = (byte)arrival;
+
+    return (true);
+}
+
 /*
  * Generate a random dungeon level
  *
  * Hack -- regenerate any "overflow" levels
  *
  * Note that this function resets "cave_feat" and "cave_info" directly.
+ *
+ * The level is built from its own random stream (see "level_seed()"),
+ * leaving the game's stream as it was.  What it was built from is kept in
+ * "gen_last" and logged, and a level recorded that way is built again
+ * if it is put in "gen_replay".
  */
 void generate_cave(void)
 {
     int y, x, i;
 
+    u32b old_value = Rand_value;
+    u16b old_place = Rand_place;
+    u32b old_state[RAND_DEG];
+    bool old_quick = Rand_quick;
+
+    u32b start;
+    int tries;
+
+    bool replay = gen_replay_set;
+    char key[40];
+
     log_info("generate_cave: Function entry - about to start");
     log_debug("generate_cave: Starting cave generation");
 
@@ -4135,6 +4248,32 @@ void generate_cave(void)
     /* The dungeon is not ready */
     character_dungeon = false;
 
+    /* Count the levels, so no two of a game get the same seed */
+    p_ptr->levels_generated++;
+
+    /* Build a recorded level again */
+    if (replay)
+    {
+        p_ptr->depth = gen_replay.depth;
+        p_ptr->stairs_taken = gen_replay.stairs_taken;
+        p_ptr->create_stair = gen_replay.create_stair;
+
+        COPY(&gen_last, &gen_replay, gen_record);
+        gen_replay_set = false;
+    }
+
+    /* Or record this one */
+    else
+    {
+        gen_last.seed = level_seed();
+        gen_last.depth = p_ptr->depth;
+        gen_last.stairs_taken = p_ptr->stairs_taken;
+        gen_last.create_stair = p_ptr->create_stair;
+    }
+
+    gen_key(key, sizeof(key), &gen_last);
+    log_info("generate_cave: level %s", key);
+
     /* Don't know feeling yet */
     do_feeling = 0;
 
@@ -4192,6 +4331,16 @@ if (playerturn == 0) {
     // you fell down)
     p_ptr->skip_next_turn = false;
 
+    /* Nothing thrown away yet */
+    C_WIPE(gen_fail_last, GEN_FAIL_MAX, u16b);
+    start = clock_msec();
+
+    /* Switch to the level's own stream */
+    C_COPY(old_state, Rand_state, RAND_DEG, u32b);
+    Rand_quick = false;
+    Rand_place = 0;
+    Rand_state_init(gen_last.seed);
+
     while (true)
     {
         bool okay = true;
@@ -4209,6 +4358,8 @@ if (playerturn == 0) {
         o_max = 1;
         mon_max = 1;
         feeling = 0;
+        gen_rooms = 0;
+        gen_vault_n = 0;
 
         /* Start with a blank cave */
         for (y = 0; y < MAX_DUNGEON_HGT; y++)
@@ -4247,6 +4398,12 @@ if (playerturn == 0) {
             wandering_pause[i] = 0;
         }
 
+        // and forget the routes around the old level
+        wipe_flow_cache();
+
+        // and how it looked
+        wipe_map_memo();
+
         /* Mega-Hack -- no player yet */
         p_ptr->px = p_ptr->py = 0;
 
@@ -4359,6 +4516,7 @@ if (playerturn == 0) {
             {
                 /* Message */
                 why = "too many objects";
+                gen_fail(GEN_FAIL_OBJECTS);
 
                 /* Message */
                 okay = false;
@@ -4369,6 +4527,7 @@ if (playerturn == 0) {
             {
                 /* Message */
                 why = "too many monsters";
+                gen_fail(GEN_FAIL_MONSTERS);
 
                 /* Message */
                 okay = false;
@@ -4393,9 +4552,41 @@ if (playerturn == 0) {
         wipe_mon_list();
     }
 
+    /* Back to the game's stream */
+    Rand_value = old_value;
+    Rand_place = old_place;
+    Rand_quick = old_quick;
+    C_COPY(Rand_state, old_state, RAND_DEG, u32b);
+
+    /* Note the cost */
+    gen_msec = clock_msec() - start;
+
+    for (tries = 1, i = 0; i < GEN_FAIL_MAX; i++)
+    {
+        tries += gen_fail_last[i];
+    }
+
+    log_debug("generate_cave: depth %d took %lu ms, %d tries", p_ptr->depth,
+        (unsigned long)gen_msec, tries);
+
+    for (i = 0; i < GEN_FAIL_MAX; i++)
+    {
+        if (gen_fail_last[i])
+            log_debug("generate_cave: %d thrown away (%s)", gen_fail_last[i],
+                gen_fail_names[i]);
+    }
+
+    if (replay)
+        msg_format("Level %s took %lu ms, %d tries.", key,
+            (unsigned long)gen_msec, tries);
+
     /* The dungeon is ready */
     character_dungeon = true;
 
+    /* Export it, if asked */
+    if (gen_dump_fff)
+        gen_dump();
+
     /* Reset the number of traps on the level. */
     num_trap_on_level = 0;
 
@@ -4419,3 +4610,116 @@ if (playerturn == 0) {
         p_ptr->thrall_quest = QUEST_COMPLETE;
     }
 }
+
+/*
+ * Mix "n" bytes at "b" into the hash "h"
+ */
+static u32b level_sum_bytes(u32b h, const void* b, size_t n)
+{
+    const byte* p = (const byte*)b;
+    size_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        h = level_seed_mix(h, p[i]);
+    }
+
+    return (h);
+}
+
+/*
+ * A hash of the current level -- its planes, lists and counters, but not
+ * the view, which is worked out again whenever it is needed
+ */
+static u32b level_sum(void)
+{
+    u32b h = 0;
+    int y, x;
+
+    for (y = 0; y < MAX_DUNGEON_HGT; y++)
+    {
+        for (x = 0; x < MAX_DUNGEON_WID; x++)
+        {
+            h = level_seed_mix(
+                h, cave_info[y][x] & ~(CAVE_VIEW | CAVE_SEEN | CAVE_FIRE));
+            h = level_seed_mix(h, cave_feat[y][x]);
+            h = level_seed_mix(h, cave_color[y][x]);
+            h = level_seed_mix(h, (u32b)cave_light[y][x]);
+            h = level_seed_mix(h, (u32b)cave_o_idx[y][x]);
+            h = level_seed_mix(h, (u32b)cave_m_idx[y][x]);
+            h = level_seed_mix(h, cave_when[y][x]);
+        }
+    }
+
+    h = level_sum_bytes(h, o_list, o_max * sizeof(object_type));
+    h = level_sum_bytes(h, mon_list, mon_max * sizeof(monster_type));
+
+    h = level_seed_mix(h, (u32b)o_cnt);
+    h = level_seed_mix(h, (u32b)mon_cnt);
+    h = level_seed_mix(h, (u32b)num_repro);
+    h = level_seed_mix(h, feeling);
+    h = level_seed_mix(h, (u32b)rating);
+    h = level_seed_mix(h, num_trap_on_level);
+    h = level_seed_mix(h, do_feeling);
+    h = level_seed_mix(h, (u32b)scent_when);
+    h = level_seed_mix(h, (u32b)styles_get_level_primary_style());
+    h = level_sum_bytes(h, g_vault_name, strlen(g_vault_name));
+
+    return (h);
+}
+
+/*
+ * Build a recorded level in a level of its own and throw it away again, to
+ * time it without leaving the current one.
+ *
+ * The character, artefacts and monster races are put back afterwards, as
+ * in the level statistics (see levstat.c).  Returns false if the current
+ * level did not come back as it was.
+ */
+bool generate_aside(const gen_record* rec)
+{
+    level_type* here = cave_level;
+    level_type* there;
+
+    player_type player_type_body;
+    artefact_type* a_body;
+    monster_race* r_body;
+    gen_record last;
+
+    u32b sum = level_sum();
+
+    /* Remember what generating a level may change */
+    COPY(&player_type_body, p_ptr, player_type);
+    C_MAKE(a_body, z_info->art_max, artefact_type);
+    C_COPY(a_body, a_info, z_info->art_max, artefact_type);
+    C_MAKE(r_body, z_info->r_max, monster_race);
+    C_COPY(r_body, r_info, z_info->r_max, monster_race);
+    COPY(&last, &gen_last, gen_record);
+
+    /* Build it */
+    there = level_make();
+    level_set(there);
+
+    COPY(&gen_replay, rec, gen_record);
+    gen_replay_set = true;
+    generate_cave();
+
+    /* Come back and forget it */
+    level_set(here);
+    level_free(there);
+
+    COPY(p_ptr, &player_type_body, player_type);
+    C_COPY(a_info, a_body, z_info->art_max, artefact_type);
+    C_COPY(r_info, r_body, z_info->r_max, monster_race);
+    COPY(&gen_last, &last, gen_record);
+    alloc_race_stamp++;
+
+    FREE(a_body);
+    FREE(r_body);
+
+    /* Work out the view again */
+    p_ptr->update |= (PU_UPDATE_VIEW | PU_MONSTERS);
+    p_ptr->redraw |= (PR_MAP);
+
+    return (level_sum() == sum);
+}
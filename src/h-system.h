@@ -29,7 +29,7 @@
 
 #if defined(Pyramid) || defined(NeXT) || defined(SUNOS) || defined(NCR3K)      \
     || defined(SUNOS) || defined(ibm032) || defined(__osf__) || defined(ISC)   \
-    || defined(SGI) || defined(linux)
+    || defined(SGI) || defined(linux) || defined(__APPLE__)
 #include <sys/time.h>
 #endif
 
@@ -1181,47 +1181,15 @@ extern void re_init_some_things(void)
 
     /*** Prepare dungeon arrays ***/
 
-    /* Padded into array */
-    FREE(cave_info);
-    C_MAKE(cave_info, MAX_DUNGEON_HGT, u16b_256);
-
-    /* Feature array */
-    FREE(cave_feat);
-    C_MAKE(cave_feat, MAX_DUNGEON_HGT, byte_wid);
-
-    /* Color array */
-    FREE(cave_color);
-    C_MAKE(cave_color, MAX_DUNGEON_HGT, byte_wid);
-
-    /* Light array */
-    FREE(cave_light);
-    C_MAKE(cave_light, MAX_DUNGEON_HGT, s16b_wid);
-
-    /* Entity arrays */
-    FREE(cave_o_idx);
-    FREE(cave_m_idx);
-    C_MAKE(cave_o_idx, MAX_DUNGEON_HGT, s16b_wid);
-    C_MAKE(cave_m_idx, MAX_DUNGEON_HGT, s16b_wid);
-
-    /* Flow arrays */
-    FREE(cave_when);
-    C_MAKE(cave_when, MAX_DUNGEON_HGT, byte_wid);
+    /* A fresh level */
+    level_free(cave_level);
+    level_set(level_make());
 
     /*** Prepare "vinfo" array ***/
 
     /* Used by "update_view()" */
     (void)vinfo_init();
 
-    /*** Prepare entity arrays ***/
-
-    /* Objects */
-    FREE(o_list);
-    C_MAKE(o_list, z_info->o_max, object_type);
-
-    /* Monsters */
-    FREE(mon_list);
-    C_MAKE(mon_list, MAX_MONSTERS, monster_type);
-
     /*** Prepare lore array ***/
 
     /* Lore */
@@ -1304,38 +1272,14 @@ static errr init_other(void)
 
     /*** Prepare dungeon arrays ***/
 
-    /* Padded into array */
-    C_MAKE(cave_info, MAX_DUNGEON_HGT, u16b_256);
-
-    /* Feature array */
-    C_MAKE(cave_feat, MAX_DUNGEON_HGT, byte_wid);
-
-    /* Color array */
-    C_MAKE(cave_color, MAX_DUNGEON_HGT, byte_wid);
-
-    /* Light array */
-    C_MAKE(cave_light, MAX_DUNGEON_HGT, s16b_wid);
-
-    /* Entity arrays */
-    C_MAKE(cave_o_idx, MAX_DUNGEON_HGT, s16b_wid);
-    C_MAKE(cave_m_idx, MAX_DUNGEON_HGT, s16b_wid);
-
-    /* Flow arrays */
-    C_MAKE(cave_when, MAX_DUNGEON_HGT, byte_wid);
+    /* The current level */
+    level_set(level_make());
 
     /*** Prepare "vinfo" array ***/
 
     /* Used by "update_view()" */
     (void)vinfo_init();
 
-    /*** Prepare entity arrays ***/
-
-    /* Objects */
-    C_MAKE(o_list, z_info->o_max, object_type);
-
-    /* Monsters */
-    C_MAKE(mon_list, MAX_MONSTERS, monster_type);
-
     /*** Prepare lore array ***/
 
     /* Lore */
@@ -1380,6 +1324,251 @@ static errr init_other(void)
     return (0);
 }
 
+/*
+ * Weight of vault "v_ptr" in the vault index at "depth", or zero if it
+ * cannot appear there.
+ *
+ * A vault's chance is inversely proportional to its rarity, with surface
+ * rooms favoured near the surface and made very much rarer below it.
+ */
+static u32b vault_weight(const vault_type* v_ptr, int depth)
+{
+    u32b rarity = MAX(v_ptr->rarity, 1);
+
+    /* Any version of Morgoth's vault will do */
+    if (v_ptr->typ == VAULT_TYP_MAX)
+        return (VAULT_WEIGHT);
+
+    /* Too deep */
+    if (v_ptr->depth > depth)
+        return (0);
+
+    /* Interesting rooms */
+    if (v_ptr->typ == 6)
+    {
+        if (depth < 6)
+        {
+            /* Surface rooms are more common at low depths */
+            if (!(v_ptr->flags & (VLT_SURFACE)))
+                rarity *= 4;
+        }
+        else if (v_ptr->flags & (VLT_SURFACE))
+        {
+            /* Surface rooms get very much rarer at depth */
+            rarity += (1L << depth);
+        }
+    }
+
+    /* Rare, but never impossible */
+    return (MAX(VAULT_WEIGHT / rarity, 1));
+}
+
+/*
+ * Initialize the vault index.
+ *
+ * Every vault type, depth and set of VAULT_PICK_XXX restrictions gets its
+ * own run of candidates in "alloc_vault_table", with the running total of
+ * their weights alongside, so that a vault is picked with a single draw.
+ */
+static errr init_alloc_vaults(void)
+{
+    int pass, t, d, p, i;
+
+    C_MAKE(alloc_vault_index, VAULT_INDEX_MAX, vault_index);
+
+    /* Count the candidates, then fill them in */
+    for (pass = 0; pass < 2; pass++)
+    {
+        alloc_vault_size = 0;
+
+        for (t = VAULT_TYP_MIN; t <= VAULT_TYP_MAX; t++)
+        {
+            for (d = 0; d <= MORGOTH_DEPTH; d++)
+            {
+                for (p = 0; p < VAULT_PICK_MAX; p++)
+                {
+                    vault_index* vi
+                        = &alloc_vault_index[VAULT_INDEX(t, d, p)];
+                    u32b total = 0;
+
+                    vi->start = alloc_vault_size;
+
+                    for (i = 1; i < z_info->v_max; i++)
+                    {
+                        vault_type* v_ptr = &v_info[i];
+                        u32b weight;
+
+                        if (v_ptr->typ != t)
+                            continue;
+                        if ((p & (VAULT_PICK_FORGE)) && !v_ptr->forge)
+                            continue;
+                        if ((p & (VAULT_PICK_TEST))
+                            && !(v_ptr->flags & (VLT_TEST)))
+                            continue;
+
+                        weight = vault_weight(v_ptr, d);
+                        if (!weight)
+                            continue;
+
+                        total += weight;
+
+                        if (pass)
+                        {
+                            alloc_vault_table[alloc_vault_size] = i;
+                            alloc_vault_total[alloc_vault_size] = total;
+                        }
+
+                        alloc_vault_size++;
+                    }
+
+                    vi->num = (u16b)(alloc_vault_size - vi->start);
+
+                    /* Paranoia -- too much for "rand_int()" */
+                    if (total > 0x1000000L)
+                        return (-1);
+                }
+            }
+        }
+
+        if (!pass)
+        {
+            C_MAKE(alloc_vault_table, MAX(alloc_vault_size, 1), s16b);
+            C_MAKE(alloc_vault_total, MAX(alloc_vault_size, 1), u32b);
+        }
+    }
+
+    /* Success */
+    return (0);
+}
+
+/*
+ * Vault glyphs which place a monster or object (see "build_vault()")
+ */
+static cptr vault_place_glyphs = "1234*&~S?CH@oOzZfFTWdyYMvabcrADRUGV";
+
+/*
+ * Initialize the vault layouts.
+ *
+ * Each vault's text is boiled down once to the grids that aren't blank
+ * (followed by the ones with something to place), so building a vault
+ * doesn't have to scan its whole text three times over.
+ */
+static errr init_vault_layouts(void)
+{
+    int pass, i;
+    u32b size;
+
+    C_MAKE(vault_layouts, z_info->v_max, vault_layout);
+
+    /* Count the grids, then fill them in */
+    for (pass = 0; pass < 2; pass++)
+    {
+        size = 0;
+
+        for (i = 1; i < z_info->v_max; i++)
+        {
+            vault_type* v_ptr = &v_info[i];
+            vault_layout* vl = &vault_layouts[i];
+            cptr data = v_text + v_ptr->text;
+            int dy, dx, step;
+
+            vl->start = size;
+            vl->num = vl->place = 0;
+            vl->max_depth = 255;
+
+            for (step = 0; step < 2; step++)
+            {
+                cptr t;
+
+                for (t = data, dy = 0; dy < v_ptr->hgt; dy++)
+                {
+                    for (dx = 0; dx < v_ptr->wid; dx++, t++)
+                    {
+                        if (*t == ' ')
+                            continue;
+
+                        if (step && !strchr(vault_place_glyphs, *t))
+                            continue;
+
+                        if (pass)
+                        {
+                            vault_op* op = &vault_ops[size];
+
+                            op->dy = (byte)dy;
+                            op->dx = (byte)dx;
+                            op->c = *t;
+                        }
+
+                        size++;
+
+                        if (step)
+                        {
+                            vl->place++;
+                            continue;
+                        }
+
+                        vl->num++;
+
+                        /* Barrow wights can't be deeper than level 15 */
+                        if (*t == 'W')
+                            vl->max_depth = MIN(vl->max_depth, 15);
+
+                        /* Chasms can't occur at 950 ft */
+                        if (*t == '7')
+                            vl->max_depth
+                                = MIN(vl->max_depth, MORGOTH_DEPTH - 2);
+                    }
+                }
+            }
+        }
+
+        if (!pass)
+            C_MAKE(vault_ops, MAX(size, 1), vault_op);
+    }
+
+    /* Success */
+    return (0);
+}
+
+/*
+ * Initialize the sets of candidates kept for an allocation table of "size"
+ * entries (see "alloc_cache_find()")
+ */
+static void init_alloc_cache(alloc_cache** cache, int size)
+{
+    int i;
+
+    C_MAKE(*cache, ALLOC_CACHE_MAX, alloc_cache);
+
+    for (i = 0; i < ALLOC_CACHE_MAX; i++)
+    {
+        alloc_cache* c = &(*cache)[i];
+
+        c->num = -1;
+        C_MAKE(c->table, MAX(size, 1), s16b);
+        C_MAKE(c->total, MAX(size, 1), u32b);
+    }
+}
+
+/*
+ * Free the sets of candidates kept for an allocation table
+ */
+static void free_alloc_cache(alloc_cache** cache)
+{
+    int i;
+
+    if (!*cache)
+        return;
+
+    for (i = 0; i < ALLOC_CACHE_MAX; i++)
+    {
+        FREE((*cache)[i].table);
+        FREE((*cache)[i].total);
+    }
+
+    KILL(*cache);
+}
+
 /*
  * Initialize some other arrays
  */
@@ -1645,6 +1834,19 @@ static errr init_alloc(void)
         }
     }
 
+    /*** Initialize vault allocation info ***/
+
+    if (init_alloc_vaults())
+        return (-1);
+
+    if (init_vault_layouts())
+        return (-1);
+
+    /*** Initialize the candidate caches ***/
+
+    init_alloc_cache(&alloc_kind_cache, alloc_kind_size);
+    init_alloc_cache(&alloc_race_cache, alloc_race_size);
+
     /* Success */
     return (0);
 }
@@ -1985,6 +2187,9 @@ extern NavResult initial_menu(bool *start_new)
 
 void cleanup_angband(void)
 {
+    /* Stop exporting levels */
+    gen_dump_close();
+
     /* Free the macros */
     macro_free();
 
@@ -1995,6 +2200,13 @@ void cleanup_angband(void)
     FREE(alloc_ego_table);
     FREE(alloc_race_table);
     FREE(alloc_kind_table);
+    free_alloc_cache(&alloc_kind_cache);
+    free_alloc_cache(&alloc_race_cache);
+    FREE(alloc_vault_index);
+    FREE(alloc_vault_table);
+    FREE(alloc_vault_total);
+    FREE(vault_layouts);
+    FREE(vault_ops);
 
     /* Free the player inventory */
     FREE(inventory);
@@ -2002,21 +2214,11 @@ void cleanup_angband(void)
     /*Clean the Autoinscribe*/
     autoinscribe_clean();
 
-    /* Free the lore, monster, and object lists */
+    /* Free the lore */
     FREE(l_list);
-    FREE(mon_list);
-    FREE(o_list);
-
-    /* Flow arrays */
-    FREE(cave_when);
-
-    /* Free the cave */
-    FREE(cave_o_idx);
-    FREE(cave_m_idx);
-    FREE(cave_feat);
-    FREE(cave_color);
-    FREE(cave_info);
-    FREE(cave_light);
+
+    /* Free the cave, its monsters and its objects */
+    level_free(cave_level);
 
     /* Free the "update_view()" array */
     FREE(view_g);
@@ -0,0 +1,415 @@
+/* File: levdump.c */
+
+/*
+ * This software may be copied and distributed for educational, research,
+ * and not for profit purposes provided that this copyright and statement
+ * are included in all such copies.  Other copyrights may also apply.
+ */
+
+#include "angband.h"
+
+/*
+ * Export of generated levels.
+ *
+ * Once "gen_dump_open()" has been called, every level "generate_cave()"
+ * builds is written out as soon as it is done, for looking over outside
+ * the game: the features and flags of every grid, the room centres, the
+ * vaults, and where each monster and object was placed.  Nothing is drawn,
+ * so this works as well from the level statistics driver (see levstat.c)
+ * as from a game.
+ *
+ * The text format is JSON lines -- each line is a JSON object of its own,
+ * and a level is the lines from a "level" line to an "end" line:
+ *
+ *   {"level":"<key>","depth":d,"hgt":h,"wid":w,"feeling":f,"tries":t,
+ *     "py":y,"px":x}
+ *   {"y":0,"feat":"<hex>","info":"<hex>"}   (one for each row)
+ *   {"rooms":[[y,x],...]}
+ *   {"vaults":[[v_idx,y,x],...]}
+ *   {"monsters":[[r_idx,y,x],...]}
+ *   {"objects":[[k_idx,y,x],...]}
+ *   {"end":"<key>"}
+ *
+ * where "feat" holds two hex digits for the feature of each grid in the
+ * row, and "info" two for its GEN_DUMP_INFO flags.  The key is the level
+ * key (see "gen_key()"), so any level can be looked at in a game with
+ * "-l<key>".  Rooms and vaults are given by their centres, and objects
+ * carried by monsters are left out.
+ *
+ * The binary format holds the same, little endian, as a record for each
+ * level: the four bytes "SLEV", a four byte length of the rest, then the
+ * seed (4), depth (2), stairs taken (2) and stairs arrived by (1) of the
+ * level key, the height, width, feeling, player y and player x (1 each),
+ * the tries (2), the features (height * width bytes) and the flags (the
+ * same), then counts (2) of rooms, vaults, monsters and objects, each
+ * followed by its entries: (y, x) for rooms, and an index (2), y and x for
+ * the rest.
+ */
+
+/*
+ * The grid flags exported -- what the generator leaves behind
+ */
+#define GEN_DUMP_INFO                                                          \
+    (CAVE_GLOW | CAVE_ICKY | CAVE_ROOM | CAVE_G_VAULT | CAVE_HIDDEN            \
+        | CAVE_WALL)
+
+/*
+ * Binary record buffer
+ */
+static byte* dump_buf = NULL;
+static size_t dump_len = 0;
+
+static void dump_byte(int b) { dump_buf[dump_len++] = (byte)b; }
+
+static void dump_u16b(u16b v)
+{
+    dump_byte(v & 0xFF);
+    dump_byte(v >> 8);
+}
+
+static void dump_u32b(u32b v)
+{
+    dump_u16b((u16b)(v & 0xFFFF));
+    dump_u16b((u16b)(v >> 16));
+}
+
+/*
+ * Number of attempts it took to generate the level
+ */
+static int gen_dump_tries(void)
+{
+    int i, tries = 1;
+
+    for (i = 0; i < GEN_FAIL_MAX; i++)
+    {
+        tries += gen_fail_last[i];
+    }
+
+    return (tries);
+}
+
+/*
+ * Count the monsters and the objects lying on the floor
+ */
+static void gen_dump_count(int* monsters, int* objects)
+{
+    int i;
+
+    *monsters = *objects = 0;
+
+    for (i = 1; i < mon_max; i++)
+    {
+        if (mon_list[i].r_idx)
+            (*monsters)++;
+    }
+
+    for (i = 1; i < o_max; i++)
+    {
+        if (o_list[i].k_idx && !o_list[i].held_m_idx)
+            (*objects)++;
+    }
+}
+
+/*
+ * Write the level as text
+ */
+static void gen_dump_text(FILE* fff)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    char key[40];
+    char feat[MAX_DUNGEON_WID * 2 + 1];
+    char info[MAX_DUNGEON_WID * 2 + 1];
+    int y, x, i;
+    cptr sep;
+
+    gen_key(key, sizeof(key), &gen_last);
+
+    fprintf(fff, "{\"level\":\"%s\",\"depth\":%d,\"hgt\":%d,\"wid\":%d,", key,
+        p_ptr->depth, p_ptr->cur_map_hgt, p_ptr->cur_map_wid);
+    fprintf(fff, "\"feeling\":%d,\"tries\":%d,\"py\":%d,\"px\":%d}\n", feeling,
+        gen_dump_tries(), p_ptr->py, p_ptr->px);
+
+    /* The grids, a row to a line */
+    for (y = 0; y < p_ptr->cur_map_hgt; y++)
+    {
+        for (x = 0; x < p_ptr->cur_map_wid; x++)
+        {
+            int f = cave_feat[y][x];
+            int c = cave_info[y][x] & (GEN_DUMP_INFO);
+
+            feat[x * 2] = hex[(f >> 4) & 0x0F];
+            feat[x * 2 + 1] = hex[f & 0x0F];
+            info[x * 2] = hex[(c >> 4) & 0x0F];
+            info[x * 2 + 1] = hex[c & 0x0F];
+        }
+
+        feat[x * 2] = info[x * 2] = '\0';
+
+        fprintf(fff, "{\"y\":%d,\"feat\":\"%s\",\"info\":\"%s\"}\n", y, feat,
+            info);
+    }
+
+    fprintf(fff, "{\"rooms\":[");
+    for (sep = "", i = 0; i < gen_rooms; i++, sep = ",")
+    {
+        fprintf(fff, "%s[%d,%d]", sep, gen_room_y[i], gen_room_x[i]);
+    }
+
+    fprintf(fff, "]}\n{\"vaults\":[");
+    for (sep = "", i = 0; i < gen_vault_n; i++, sep = ",")
+    {
+        fprintf(fff, "%s[%d,%d,%d]", sep, gen_vault_idx[i], gen_vault_y[i],
+            gen_vault_x[i]);
+    }
+
+    fprintf(fff, "]}\n{\"monsters\":[");
+    for (sep = "", i = 1; i < mon_max; i++)
+    {
+        monster_type* m_ptr = &mon_list[i];
+
+        if (!m_ptr->r_idx)
+            continue;
+
+        fprintf(fff, "%s[%d,%d,%d]", sep, m_ptr->r_idx, m_ptr->fy, m_ptr->fx);
+        sep = ",";
+    }
+
+    fprintf(fff, "]}\n{\"objects\":[");
+    for (sep = "", i = 1; i < o_max; i++)
+    {
+        object_type* o_ptr = &o_list[i];
+
+        if (!o_ptr->k_idx || o_ptr->held_m_idx)
+            continue;
+
+        fprintf(fff, "%s[%d,%d,%d]", sep, o_ptr->k_idx, o_ptr->iy, o_ptr->ix);
+        sep = ",";
+    }
+
+    fprintf(fff, "]}\n{\"end\":\"%s\"}\n", key);
+}
+
+/*
+ * Write the level as a binary record
+ */
+static void gen_dump_bin(FILE* fff)
+{
+    int hgt = p_ptr->cur_map_hgt;
+    int wid = p_ptr->cur_map_wid;
+    int monsters, objects;
+    int y, x, i;
+
+    gen_dump_count(&monsters, &objects);
+
+    C_MAKE(dump_buf,
+        32 + 2 * hgt * wid + 2 * gen_rooms + 4 * gen_vault_n + 4 * monsters
+            + 4 * objects,
+        byte);
+    dump_len = 0;
+
+    /* Header (the length is filled in below) */
+    dump_byte('S');
+    dump_byte('L');
+    dump_byte('E');
+    dump_byte('V');
+    dump_u32b(0);
+
+    dump_u32b(gen_last.seed);
+    dump_u16b((u16b)gen_last.depth);
+    dump_u16b(gen_last.stairs_taken);
+    dump_byte(gen_last.create_stair);
+    dump_byte(hgt);
+    dump_byte(wid);
+    dump_byte(feeling);
+    dump_byte(p_ptr->py);
+    dump_byte(p_ptr->px);
+    dump_u16b((u16b)gen_dump_tries());
+
+    for (y = 0; y < hgt; y++)
+    {
+        for (x = 0; x < wid; x++)
+        {
+            dump_byte(cave_feat[y][x]);
+        }
+    }
+
+    for (y = 0; y < hgt; y++)
+    {
+        for (x = 0; x < wid; x++)
+        {
+            dump_byte(cave_info[y][x] & (GEN_DUMP_INFO));
+        }
+    }
+
+    dump_u16b((u16b)gen_rooms);
+    for (i = 0; i < gen_rooms; i++)
+    {
+        dump_byte(gen_room_y[i]);
+        dump_byte(gen_room_x[i]);
+    }
+
+    dump_u16b((u16b)gen_vault_n);
+    for (i = 0; i < gen_vault_n; i++)
+    {
+        dump_u16b((u16b)gen_vault_idx[i]);
+        dump_byte(gen_vault_y[i]);
+        dump_byte(gen_vault_x[i]);
+    }
+
+    dump_u16b((u16b)monsters);
+    for (i = 1; i < mon_max; i++)
+    {
+        monster_type* m_ptr = &mon_list[i];
+
+        if (!m_ptr->r_idx)
+            continue;
+
+        dump_u16b((u16b)m_ptr->r_idx);
+        dump_byte(m_ptr->fy);
+        dump_byte(m_ptr->fx);
+    }
+
+    dump_u16b((u16b)objects);
+    for (i = 1; i < o_max; i++)
+    {
+        object_type* o_ptr = &o_list[i];
+
+        if (!o_ptr->k_idx || o_ptr->held_m_idx)
+            continue;
+
+        dump_u16b((u16b)o_ptr->k_idx);
+        dump_byte(o_ptr->iy);
+        dump_byte(o_ptr->ix);
+    }
+
+    /* Fill in the length */
+    i = (int)dump_len - 8;
+    dump_buf[4] = (byte)(i & 0xFF);
+    dump_buf[5] = (byte)((i >> 8) & 0xFF);
+    dump_buf[6] = (byte)((i >> 16) & 0xFF);
+    dump_buf[7] = (byte)((i >> 24) & 0xFF);
+
+    (void)fwrite(dump_buf, 1, dump_len, fff);
+
+    KILL(dump_buf);
+}
+
+/*
+ * Write the level just generated to "gen_dump_fff"
+ */
+void gen_dump(void)
+{
+    if (!gen_dump_fff)
+        return;
+
+    if (gen_dump_binary)
+        gen_dump_bin(gen_dump_fff);
+    else
+        gen_dump_text(gen_dump_fff);
+
+    /* Let a reader at the other end see each level as it comes */
+    fflush(gen_dump_fff);
+}
+
+/*
+ * Copy one level, as written by "gen_dump()", from "in" to "out", returning
+ * false if there are no more.
+ */
+bool gen_dump_copy(FILE* in, FILE* out, bool binary)
+{
+    if (binary)
+    {
+        byte head[8];
+        size_t len;
+        char buf[4096];
+
+        if (fread(head, 1, sizeof(head), in) != sizeof(head))
+            return (false);
+
+        len = (size_t)head[4] | ((size_t)head[5] << 8)
+            | ((size_t)head[6] << 16) | ((size_t)head[7] << 24);
+
+        (void)fwrite(head, 1, sizeof(head), out);
+
+        while (len)
+        {
+            size_t n = fread(buf, 1, MIN(len, sizeof(buf)), in);
+
+            if (!n)
+                return (false);
+
+            (void)fwrite(buf, 1, n, out);
+            len -= n;
+        }
+    }
+    else
+    {
+        cptr end = "{\"end\"";
+        bool last = false;
+        int i = 0;
+        int c;
+
+        /* Copy lines until the "end" line has been */
+        while ((c = getc(in)) != EOF)
+        {
+            putc(c, out);
+
+            if (c == '\n')
+            {
+                if (last)
+                    break;
+                i = 0;
+            }
+            else if ((i >= 0) && end[i] && (c == end[i]))
+            {
+                i++;
+                if (!end[i])
+                    last = true;
+            }
+            else
+            {
+                i = -1;
+            }
+        }
+
+        if (c == EOF)
+            return (false);
+    }
+
+    return (true);
+}
+
+/*
+ * Start writing each level generated to "dest", a file name, as text, or
+ * as binary if it is "bin:" followed by the file name.
+ */
+errr gen_dump_open(cptr dest)
+{
+    char buf[1024];
+
+    gen_dump_close();
+
+    gen_dump_binary = prefix(dest, "bin:");
+    if (gen_dump_binary)
+        dest += 4;
+
+    path_parse(buf, sizeof(buf), dest);
+
+    gen_dump_fff = my_fopen(buf, gen_dump_binary ? "wb" : "w");
+    if (!gen_dump_fff)
+        return (-1);
+
+    return (0);
+}
+
+/*
+ * Stop writing levels
+ */
+void gen_dump_close(void)
+{
+    if (gen_dump_fff)
+        my_fclose(gen_dump_fff);
+
+    gen_dump_fff = NULL;
+}
@@ -0,0 +1,630 @@
+/* File: levstat.c */
+
+/*
+ * This software may be copied and distributed for educational, research,
+ * and not for profit purposes provided that this copyright and statement
+ * are included in all such copies.  Other copyrights may also apply.
+ */
+
+#include "angband.h"
+
+#ifdef SET_UID
+#include <sys/wait.h>
+#endif /* SET_UID */
+
+/*
+ * Headless level generation statistics.
+ *
+ * Generates a number of levels at each depth in a range, using the real
+ * generator ("generate_cave()"), and reports on each of them: how long it
+ * took, how many attempts were thrown away (and why), and what ended up on
+ * it -- rooms, vaults, monsters, objects, forges, open floor and stairs.
+ *
+ * Each level is built from its own level key (see "gen_key()"), drawn from
+ * a stream seeded with the base seed, and the character, artefacts and
+ * monster races are put back after each one.  So the levels in a report
+ * depend only on the base seed, and any of them can be looked at in a new
+ * game with "-l<key>".
+ *
+ * The generator keeps the level (and the RNG) in globals, so the work is
+ * shared out between processes rather than threads: each worker is forked
+ * once the game data is loaded, builds every "jobs"th level, and sends one
+ * record per level down a pipe.  The parent puts the records back in order
+ * and writes them to "levstat.csv", with totals for each depth and for each
+ * vault in "levstat.json" (both in the user directory).
+ *
+ * If levels are being exported (see levdump.c), a single worker streams
+ * them out as they are built.  Several workers each export to a temporary
+ * file of their own, and the parent puts the levels back in order at the
+ * end, so the export doesn't depend on the number of jobs either.
+ */
+
+/*
+ * What was generated for one level
+ */
+typedef struct levstat_row levstat_row;
+
+struct levstat_row
+{
+    gen_record rec; /* What it was built from */
+    s16b n; /* Number of the level at its depth */
+
+    u32b msec; /* Time taken */
+    u16b fail[GEN_FAIL_MAX]; /* Attempts thrown away */
+
+    s16b hgt;
+    s16b wid;
+    s16b rooms;
+    s16b monsters;
+    s16b objects;
+    s16b forges;
+    s16b floors; /* Grids the player could walk over (ignoring rubble) */
+    s16b up;
+    s16b down;
+    s16b feeling;
+
+    s16b vault_n;
+    s16b vault_idx[GEN_VAULT_MAX];
+};
+
+/*
+ * Totals for one depth
+ */
+typedef struct levstat_sum levstat_sum;
+
+struct levstat_sum
+{
+    long levels;
+    u32b msec;
+    u32b msec_max;
+    long tries;
+    long fail[GEN_FAIL_MAX];
+    long rooms;
+    long monsters;
+    long objects;
+    long forges;
+    long floors;
+    long vaults;
+};
+
+/*
+ * A silent term, so the game can be loaded with no display
+ */
+static term levstat_term_body;
+
+static errr Term_xtra_levstat(int n, int v)
+{
+    /* Unused parameter */
+    (void)v;
+
+    /* Answer any prompt with escape, rather than waiting forever */
+    if (n == TERM_XTRA_EVENT)
+        return (Term_keypress(ESCAPE));
+
+    return (0);
+}
+
+static errr Term_curs_levstat(int x, int y)
+{
+    /* Unused parameters */
+    (void)x;
+    (void)y;
+
+    return (0);
+}
+
+static errr Term_wipe_levstat(int x, int y, int n)
+{
+    /* Unused parameters */
+    (void)x;
+    (void)y;
+    (void)n;
+
+    return (0);
+}
+
+static errr Term_text_levstat(int x, int y, int n, byte a, cptr s)
+{
+    /* Unused parameters */
+    (void)x;
+    (void)y;
+    (void)n;
+    (void)a;
+    (void)s;
+
+    return (0);
+}
+
+/*
+ * Prepare the silent term as the main term
+ */
+void init_levstat_term(void)
+{
+    term* t = &levstat_term_body;
+
+    term_init(t, 80, 24, 256);
+
+    t->text_hook = Term_text_levstat;
+    t->wipe_hook = Term_wipe_levstat;
+    t->curs_hook = Term_curs_levstat;
+    t->xtra_hook = Term_xtra_levstat;
+
+    Term_activate(t);
+
+    angband_term[0] = t;
+}
+
+/*
+ * Look over the level just generated
+ */
+static void levstat_count(levstat_row* row)
+{
+    int y, x;
+
+    row->hgt = p_ptr->cur_map_hgt;
+    row->wid = p_ptr->cur_map_wid;
+    row->rooms = gen_rooms;
+    row->monsters = mon_cnt;
+    row->objects = o_cnt;
+    row->feeling = feeling;
+
+    row->vault_n = gen_vault_n;
+    C_COPY(row->vault_idx, gen_vault_idx, gen_vault_n, s16b);
+
+    for (y = 0; y < p_ptr->cur_map_hgt; y++)
+    {
+        for (x = 0; x < p_ptr->cur_map_wid; x++)
+        {
+            if (cave_forge_bold(y, x))
+                row->forges++;
+            if (cave_up_stairs_bold(y, x))
+                row->up++;
+            if (cave_down_stairs_bold(y, x))
+                row->down++;
+
+            if (in_bounds_fully(y, x) && player_passable(y, x, true))
+                row->floors++;
+        }
+    }
+}
+
+/*
+ * Send a record to the parent (a write this small to a pipe is never mixed
+ * up with another worker's)
+ */
+static bool levstat_send(int fd, const levstat_row* row)
+{
+    const char* buf = (const char*)row;
+    size_t len = sizeof(levstat_row);
+
+    while (len)
+    {
+        ssize_t n = write(fd, buf, len);
+
+        if (n <= 0)
+            return (false);
+
+        buf += n;
+        len -= (size_t)n;
+    }
+
+    return (true);
+}
+
+/*
+ * Generate this worker's share of the levels, passing the records to "fd"
+ * (or straight into "rows" when there is no pipe)
+ */
+static void levstat_work(int d_min, int d_max, int levels, int job, int jobs,
+    u32b seed, int fd, levstat_row* rows)
+{
+    player_type player_type_body;
+    artefact_type* a_body;
+    monster_race* r_body;
+
+    int depth, n, i = 0;
+
+    /* Remember what generating a level may change */
+    COPY(&player_type_body, p_ptr, player_type);
+    C_MAKE(a_body, z_info->art_max, artefact_type);
+    C_COPY(a_body, a_info, z_info->art_max, artefact_type);
+    C_MAKE(r_body, z_info->r_max, monster_race);
+    C_COPY(r_body, r_info, z_info->r_max, monster_race);
+
+    /* The stream of level seeds */
+    Rand_quick = false;
+    Rand_place = 0;
+    Rand_state_init(seed);
+
+    for (depth = d_min; depth <= d_max; depth++)
+    {
+        for (n = 0; n < levels; n++, i++)
+        {
+            levstat_row row;
+
+            /* Every worker draws every seed, so they all see the same ones */
+            u32b level = ((u32b)Rand_div(0x10000) << 16) | Rand_div(0x10000);
+
+            if (i % jobs != job)
+                continue;
+
+            WIPE(&row, levstat_row);
+
+            row.rec.seed = level;
+            row.rec.depth = depth;
+            row.n = n;
+
+            /* Build it */
+            COPY(&gen_replay, &row.rec, gen_record);
+            gen_replay_set = true;
+            generate_cave();
+
+            row.msec = gen_msec;
+            C_COPY(row.fail, gen_fail_last, GEN_FAIL_MAX, u16b);
+            levstat_count(&row);
+
+            if (fd >= 0)
+            {
+                if (!levstat_send(fd, &row))
+                    break;
+            }
+            else
+            {
+                COPY(&rows[i], &row, levstat_row);
+            }
+
+            /* Leave it, forgetting any messages and greater vault */
+            wipe_o_list();
+            wipe_mon_list();
+            msg_print(NULL);
+            g_vault_name[0] = '\0';
+
+            COPY(p_ptr, &player_type_body, player_type);
+            C_COPY(a_info, a_body, z_info->art_max, artefact_type);
+            C_COPY(r_info, r_body, z_info->r_max, monster_race);
+            alloc_race_stamp++;
+        }
+    }
+
+    FREE(a_body);
+    FREE(r_body);
+}
+
+/*
+ * Number of attempts it took to generate a level
+ */
+static int levstat_tries(const levstat_row* row)
+{
+    int i, tries = 1;
+
+    for (i = 0; i < GEN_FAIL_MAX; i++)
+    {
+        tries += row->fail[i];
+    }
+
+    return (tries);
+}
+
+/*
+ * Write a string as a JSON string
+ */
+static void levstat_json_str(FILE* fff, cptr s)
+{
+    fputc('"', fff);
+
+    for (; *s; s++)
+    {
+        if ((*s == '"') || (*s == '\\'))
+            fputc('\\', fff);
+        fputc(*s, fff);
+    }
+
+    fputc('"', fff);
+}
+
+/*
+ * Write the records, in order, as CSV
+ */
+static void levstat_csv(FILE* fff, const levstat_row* rows, int total)
+{
+    int i, j;
+
+    fprintf(fff, "depth,n,key,msec,tries");
+    for (j = 0; j < GEN_FAIL_MAX; j++)
+    {
+        fprintf(fff, ",fail_%s", gen_fail_names[j]);
+    }
+    fprintf(fff, ",hgt,wid,rooms,monsters,objects,forges,floors,up,down,"
+                 "feeling,vaults\n");
+
+    for (i = 0; i < total; i++)
+    {
+        const levstat_row* row = &rows[i];
+        char key[40];
+
+        gen_key(key, sizeof(key), &row->rec);
+
+        fprintf(fff, "%d,%d,%s,%lu,%d", row->rec.depth, row->n, key,
+            (unsigned long)row->msec, levstat_tries(row));
+        for (j = 0; j < GEN_FAIL_MAX; j++)
+        {
+            fprintf(fff, ",%d", row->fail[j]);
+        }
+        fprintf(fff, ",%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,", row->hgt, row->wid,
+            row->rooms, row->monsters, row->objects, row->forges, row->floors,
+            row->up, row->down, row->feeling);
+
+        /* Vaults by index, separated by spaces */
+        for (j = 0; j < row->vault_n; j++)
+        {
+            fprintf(fff, "%s%d", j ? " " : "", row->vault_idx[j]);
+        }
+        fprintf(fff, "\n");
+    }
+}
+
+/*
+ * Write the totals for each depth and each vault as JSON
+ */
+static void levstat_json(FILE* fff, const levstat_row* rows, int total,
+    int d_min, int d_max, int jobs, u32b seed, u32b msec)
+{
+    levstat_sum sums[MORGOTH_DEPTH + 1];
+    long* vaults;
+    int depth, i, j;
+    bool first;
+
+    C_WIPE(sums, MORGOTH_DEPTH + 1, levstat_sum);
+    C_MAKE(vaults, z_info->v_max, long);
+
+    for (i = 0; i < total; i++)
+    {
+        const levstat_row* row = &rows[i];
+        levstat_sum* s = &sums[row->rec.depth];
+
+        s->levels++;
+        s->msec += row->msec;
+        s->msec_max = MAX(s->msec_max, row->msec);
+        s->tries += levstat_tries(row);
+        for (j = 0; j < GEN_FAIL_MAX; j++)
+        {
+            s->fail[j] += row->fail[j];
+        }
+        s->rooms += row->rooms;
+        s->monsters += row->monsters;
+        s->objects += row->objects;
+        s->forges += row->forges;
+        s->floors += row->floors;
+        s->vaults += row->vault_n;
+
+        for (j = 0; j < row->vault_n; j++)
+        {
+            vaults[row->vault_idx[j]]++;
+        }
+    }
+
+    fprintf(fff, "{\n  \"seed\": %lu,\n  \"jobs\": %d,\n  \"levels\": %d,\n",
+        (unsigned long)seed, jobs, total);
+    fprintf(fff, "  \"msec\": %lu,\n  \"depths\": [\n", (unsigned long)msec);
+
+    for (depth = d_min; depth <= d_max; depth++)
+    {
+        const levstat_sum* s = &sums[depth];
+        double n = (double)MAX(s->levels, 1);
+
+        fprintf(fff, "    { \"depth\": %d, \"levels\": %ld, ", depth,
+            s->levels);
+        fprintf(fff, "\"msec_mean\": %.2f, \"msec_max\": %lu, ", s->msec / n,
+            (unsigned long)s->msec_max);
+        fprintf(fff, "\"tries_mean\": %.2f, \"fail\": { ", s->tries / n);
+        for (j = 0; j < GEN_FAIL_MAX; j++)
+        {
+            fprintf(fff, "%s\"%s\": %ld", j ? ", " : "", gen_fail_names[j],
+                s->fail[j]);
+        }
+        fprintf(fff, " }, \"rooms_mean\": %.2f, \"monsters_mean\": %.2f, ",
+            s->rooms / n, s->monsters / n);
+        fprintf(fff, "\"objects_mean\": %.2f, \"forges_mean\": %.2f, ",
+            s->objects / n, s->forges / n);
+        fprintf(fff, "\"floors_mean\": %.1f, \"vaults_mean\": %.2f }%s\n",
+            s->floors / n, s->vaults / n, (depth < d_max) ? "," : "");
+    }
+
+    fprintf(fff, "  ],\n  \"vaults\": [\n");
+
+    for (first = true, i = 0; i < z_info->v_max; i++)
+    {
+        vault_type* v_ptr = &v_info[i];
+
+        if (!vaults[i])
+            continue;
+
+        fprintf(fff, "%s    { \"idx\": %d, \"name\": ", first ? "" : ",\n", i);
+        levstat_json_str(fff, v_name + v_ptr->name);
+        fprintf(fff, ", \"typ\": %d, \"count\": %ld }", v_ptr->typ, vaults[i]);
+
+        first = false;
+    }
+
+    fprintf(fff, "%s  ]\n}\n", first ? "" : "\n");
+
+    FREE(vaults);
+}
+
+/*
+ * Generate the levels asked for by "spec", which is of the form
+ * "<from>-<to>:<levels>[:<jobs>[:<seed>]]", and write the reports.
+ *
+ * By default there is one job for each processor, and the seed is taken
+ * from the clock.
+ */
+void levstat_run(cptr spec)
+{
+    int d_min, d_max, levels, jobs = 0;
+    unsigned long seed = 0;
+    int total, job, i;
+
+    levstat_row* rows;
+    u32b start = clock_msec();
+
+    char buf[1024];
+    FILE* fff;
+
+    if (sscanf(spec, "%d-%d:%d:%d:%lu", &d_min, &d_max, &levels, &jobs, &seed)
+        < 3)
+        quit_fmt("Bad level statistics '%s'", spec);
+
+    if ((d_min < 0) || (d_max > MORGOTH_DEPTH) || (d_min > d_max)
+        || (levels <= 0) || (levels > 0x7FFF))
+        quit_fmt("Bad level statistics '%s'", spec);
+
+    if (!seed)
+        seed = (unsigned long)time(NULL);
+
+#ifdef SET_UID
+
+    if (jobs <= 0)
+        jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+#endif /* SET_UID */
+
+    total = (d_max - d_min + 1) * levels;
+    jobs = MAX(1, MIN(jobs, total));
+
+    C_MAKE(rows, total, levstat_row);
+
+    /* Levels as they would be for a new character (skipping the poetry) */
+    player_wipe();
+    playerturn = 1;
+
+#ifdef SET_UID
+
+    if (jobs > 1)
+    {
+        int fd[2];
+        int got = 0;
+        levstat_row row;
+        size_t have = 0;
+        FILE* out = gen_dump_fff;
+        FILE** parts = NULL;
+
+        if (pipe(fd) < 0)
+            quit("Cannot make a pipe for the level statistics");
+
+        /* A file for each worker's exported levels */
+        if (out)
+        {
+            fflush(out);
+            C_MAKE(parts, jobs, FILE*);
+
+            for (job = 0; job < jobs; job++)
+            {
+                parts[job] = tmpfile();
+                if (!parts[job])
+                    quit("Cannot make a file for the exported levels");
+            }
+        }
+
+        /* Start the workers */
+        for (job = 0; job < jobs; job++)
+        {
+            pid_t pid = fork();
+
+            if (pid < 0)
+                quit("Cannot start the level statistics workers");
+
+            if (!pid)
+            {
+                (void)fd_close(fd[0]);
+                if (parts)
+                    gen_dump_fff = parts[job];
+                levstat_work(d_min, d_max, levels, job, jobs, (u32b)seed,
+                    fd[1], NULL);
+                if (parts)
+                    fflush(parts[job]);
+                _exit(0);
+            }
+        }
+
+        (void)fd_close(fd[1]);
+
+        /* Gather the records, putting them in order */
+        while (got < total)
+        {
+            ssize_t n = read(fd[0], (char*)&row + have, sizeof(row) - have);
+
+            if (n <= 0)
+                break;
+
+            have += (size_t)n;
+            if (have < sizeof(row))
+                continue;
+
+            COPY(&rows[(row.rec.depth - d_min) * levels + row.n], &row,
+                levstat_row);
+            have = 0;
+            got++;
+        }
+
+        (void)fd_close(fd[0]);
+
+        while (wait(NULL) > 0) /* loop */
+            ;
+
+        if (got < total)
+            quit_fmt("Only %d of %d levels were generated", got, total);
+
+        /* Put the exported levels in order (each worker built every
+         * "jobs"th one) */
+        if (parts)
+        {
+            for (job = 0; job < jobs; job++)
+            {
+                rewind(parts[job]);
+            }
+
+            for (i = 0; i < total; i++)
+            {
+                if (!gen_dump_copy(parts[i % jobs], out, gen_dump_binary))
+                    quit("Cannot gather the exported levels");
+            }
+
+            for (job = 0; job < jobs; job++)
+            {
+                fclose(parts[job]);
+            }
+
+            fflush(out);
+            FREE(parts);
+        }
+    }
+    else
+
+#endif /* SET_UID */
+
+    {
+        jobs = 1;
+        levstat_work(d_min, d_max, levels, 0, 1, (u32b)seed, -1, rows);
+    }
+
+    /* Write the reports */
+    path_build(buf, sizeof(buf), ANGBAND_DIR_USER, "levstat.csv");
+    fff = my_fopen(buf, "w");
+    if (!fff)
+        quit_fmt("Cannot write '%s'", buf);
+    levstat_csv(fff, rows, total);
+    my_fclose(fff);
+
+    path_build(buf, sizeof(buf), ANGBAND_DIR_USER, "levstat.json");
+    fff = my_fopen(buf, "w");
+    if (!fff)
+        quit_fmt("Cannot write '%s'", buf);
+    levstat_json(fff, rows, total, d_min, d_max, jobs, (u32b)seed,
+        clock_msec() - start);
+    my_fclose(fff);
+
+    printf("%d levels in %lu ms (%d jobs, seed %lu), see %s\n", total,
+        (unsigned long)(clock_msec() - start), jobs, seed, buf);
+
+    FREE(rows);
+}
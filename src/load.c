@@ -861,9 +861,10 @@ static errr rd_extra(void)
     rd_byte(&p_ptr->stealth_mode);
     rd_byte(&p_ptr->self_made_arts);
     rd_byte(&p_ptr->climbing);
+    rd_u32b(&p_ptr->levels_generated);
 
-    // 19 spare bytes
-    strip_bytes(19);
+    // 15 spare bytes
+    strip_bytes(15);
 
     /* Read item-quality squelch sub-menu */
     for (i = 0; i < SQUELCH_BYTES; i++)
@@ -1661,6 +1662,10 @@ static errr rd_dungeon(void)
         m_ptr->hold_o_idx = i;
     }
 
+    // routes cached on any previous level are no longer valid
+    wipe_flow_cache();
+    wipe_map_memo();
+
     // dump the wandering monster information
     for (i = FLOW_WANDERING_HEAD; i <= FLOW_WANDERING_TAIL; i++)
     {
@@ -1775,6 +1780,9 @@ static errr rd_savefile_new_aux(void)
         /* Read the lore */
         rd_lore(i);
     }
+
+    /* The racial limits have changed */
+    alloc_race_stamp++;
     if (arg_fiddle)
         note("Loaded Monster Memory");
 
@@ -38,6 +38,8 @@ static struct {
   Callback callbacks[MAX_CALLBACKS];
 } L;
 
+int log_threshold = LOG_TRACE;
+
 
 static const char *level_strings[] = {
   "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
@@ -81,6 +83,15 @@ static void file_callback(log_Event *ev) {
 }
 
 
+static void update_threshold(void) {
+  int level = L.quiet ? LOG_FATAL + 1 : L.level;
+  for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+    if (L.callbacks[i].level < level) { level = L.callbacks[i].level; }
+  }
+  log_threshold = level;
+}
+
+
 static void lock(void)   {
   if (L.lock) { L.lock(true, L.udata); }
 }
@@ -104,11 +115,13 @@ void log_set_lock(log_LockFn fn, void *udata) {
 
 void log_set_level(int level) {
   L.level = level;
+  update_threshold();
 }
 
 
 void log_set_quiet(bool enable) {
   L.quiet = enable;
+  update_threshold();
 }
 
 
@@ -116,6 +129,7 @@ int log_add_callback(log_LogFn fn, void *udata, int level) {
   for (int i = 0; i < MAX_CALLBACKS; i++) {
     if (!L.callbacks[i].fn) {
       L.callbacks[i] = (Callback) { fn, udata, level };
+      update_threshold();
       return 0;
     }
   }
@@ -137,6 +151,28 @@ static void init_event(log_Event *ev, void *udata) {
 }
 
 
+bool log_allow(log_Limit *lim, int per_sec, int level, const char *file, int line) {
+  time_t now = time(NULL);
+
+  if (now != lim->second) {
+    if (lim->dropped) {
+      log_log(level, file, line, "(%d similar messages suppressed)", lim->dropped);
+    }
+    lim->second = now;
+    lim->count = 0;
+    lim->dropped = 0;
+  }
+
+  if (lim->count < per_sec) {
+    lim->count++;
+    return true;
+  }
+
+  lim->dropped++;
+  return false;
+}
+
+
 void log_log(int level, const char *file, int line, const char *fmt, ...) {
   log_Event ev = {
     .fmt   = fmt,
@@ -175,4 +211,5 @@ void log_close_files()
             L.callbacks[i] = (Callback){0};
         }
     }
+    update_threshold();
 }
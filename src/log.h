@@ -30,12 +30,45 @@ typedef void (*log_LockFn)(bool lock, void *udata);
 
 enum { LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_FATAL };
 
-#define log_trace(...) log_log(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
-#define log_debug(...) log_log(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
-#define log_info(...)  log_log(LOG_INFO,  __FILE__, __LINE__, __VA_ARGS__)
-#define log_warn(...)  log_log(LOG_WARN,  __FILE__, __LINE__, __VA_ARGS__)
-#define log_error(...) log_log(LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
-#define log_fatal(...) log_log(LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
+/* Calls below this level are compiled out (e.g. -DLOG_MIN_LEVEL=LOG_INFO) */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_TRACE
+#endif
+
+/* Lowest level that the console or any callback will accept */
+extern int log_threshold;
+
+/* Checked before the arguments of a log call are evaluated */
+#define log_enabled(level) \
+  ((level) >= LOG_MIN_LEVEL && (level) >= log_threshold)
+
+#define log_at(level, ...) \
+  do { \
+    if (log_enabled(level)) \
+      log_log(level, __FILE__, __LINE__, __VA_ARGS__); \
+  } while (0)
+
+typedef struct {
+  time_t second;
+  int count;
+  int dropped;
+} log_Limit;
+
+/* As log_at(), but at most `per_sec` messages a second from this call site */
+#define log_limited(level, per_sec, ...) \
+  do { \
+    static log_Limit log_limit_; \
+    if (log_enabled(level) && \
+        log_allow(&log_limit_, per_sec, level, __FILE__, __LINE__)) \
+      log_log(level, __FILE__, __LINE__, __VA_ARGS__); \
+  } while (0)
+
+#define log_trace(...) log_at(LOG_TRACE, __VA_ARGS__)
+#define log_debug(...) log_at(LOG_DEBUG, __VA_ARGS__)
+#define log_info(...)  log_at(LOG_INFO,  __VA_ARGS__)
+#define log_warn(...)  log_at(LOG_WARN,  __VA_ARGS__)
+#define log_error(...) log_at(LOG_ERROR, __VA_ARGS__)
+#define log_fatal(...) log_at(LOG_FATAL, __VA_ARGS__)
 
 const char* log_level_string(int level);
 void log_set_lock(log_LockFn fn, void *udata);
@@ -45,6 +78,7 @@ int log_add_callback(log_LogFn fn, void *udata, int level);
 int log_add_fp(FILE *fp, int level);
 void log_close_files();
 
+bool log_allow(log_Limit *lim, int per_sec, int level, const char *file, int line);
 void log_log(int level, const char *file, int line, const char *fmt, ...);
 
 #endif
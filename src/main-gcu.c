@@ -887,6 +887,64 @@ static errr Term_text_gcu(int x, int y, int n, byte a, cptr s)
     return (0);
 }
 
+/*
+ * Place some text on the screen using several attributes
+ *
+ * Each run of characters sharing an attribute is sent to curses in one go,
+ * setting the attribute only once, rather than one character at a time.
+ */
+static errr Term_span_gcu(int x, int y, int n, const byte* ap, cptr s)
+{
+    term_data* td = (term_data*)(Term->data);
+
+    int i, j, k;
+
+    /* Move the cursor */
+    wmove(td->win, y, x);
+
+    /* Draw each run of characters in the same attribute */
+    for (i = 0; i < n; i = j)
+    {
+        byte a = ap[i];
+        bool plain = true;
+
+        /* Find the end of the run, noting any special characters */
+        for (j = i; (j < n) && (ap[j] == a); j++)
+        {
+            if (s[j] & 0x80)
+                plain = false;
+        }
+
+        /* Erase */
+        if (!a && !Term->always_text)
+        {
+            for (k = i; k < j; k++)
+                waddch(td->win, ' ');
+        }
+
+        /* Draw plain text all at once */
+        else if (plain)
+        {
+#ifdef A_COLOR
+            /* Set the color */
+            if (can_use_color)
+                wattrset(td->win, colortable[a & 0x0F]);
+#endif
+
+            waddnstr(td->win, s + i, j - i);
+        }
+
+        /* Draw special characters one at a time */
+        else
+        {
+            (void)Term_text_gcu(x + i, y, j - i, a, s + i);
+        }
+    }
+
+    /* Success */
+    return (0);
+}
+
 /*
  * Create a window for the given "term_data" argument.
  *
@@ -922,6 +980,7 @@ static errr term_data_init_gcu(term_data* td, int rows, int cols, int y, int x)
 
     /* Set some more hooks */
     t->text_hook = Term_text_gcu;
+    t->span_hook = Term_span_gcu;
     t->wipe_hook = Term_wipe_gcu;
     t->curs_hook = Term_curs_gcu;
     t->xtra_hook = Term_xtra_gcu;
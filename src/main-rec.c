@@ -0,0 +1,883 @@
+/* File: main-rec.c */
+
+/*
+ * Copyright (c) 1997 Ben Harrison, and others
+ *
+ * This software may be copied and distributed for educational, research,
+ * and not for profit purposes provided that this copyright and statement
+ * are included in all such copies.
+ */
+
+/*
+ * This file records the main screen as a stream of frames, to a file or
+ * to a local viewer listening on a Unix socket.
+ *
+ *
+ * To use this file, you must define "USE_REC" in the Makefile, and then
+ * ask for a recording with "-x<file>" or "-xunix:<path>".
+ *
+ *
+ * Unlike the other "main-xxx.c" files this is not a display module of its
+ * own.  It is layered on top of whichever module was chosen, by wrapping
+ * the "xtra_hook" of the main term, and writes a frame every time that
+ * term is flushed.  Only the text layer is recorded, so a game played
+ * with graphics is recorded as it would look in a plain terminal.
+ *
+ * The stream starts with the six bytes "SILREC" and a version byte.
+ * Each frame then starts with a tag byte and a four byte timestamp, in
+ * milliseconds since the recording started (all multi-byte values are
+ * little endian):
+ *
+ *   'K' (keyframe): width, height, cursor x, cursor y, cursor flags,
+ *       then one span (see below) for every row of the screen.
+ *
+ *   'D' (delta): cursor x, cursor y, cursor flags, a two byte count of
+ *       spans, then the spans themselves.
+ *
+ * A span is a row, a column and a length "n" (a byte each), the "n"
+ * characters, then the attributes as (count, attr) pairs covering the
+ * "n" characters.  The cursor flags are 0x01 for "visible" and 0x02 for
+ * "useless".  Columns past the 255th are not recorded.
+ *
+ * Delta frames hold only the cells which changed since the last frame,
+ * with short runs of unchanged cells folded into the spans around them.
+ * A keyframe is written at the start, whenever the screen changes size,
+ * and every REC_KEYFRAME frames after that, so a viewer can join (or a
+ * replay can seek) without reading the whole stream.
+ *
+ * A recording can be played back on the screen with "-p<file>", or watched
+ * live with "-punix:<path>", which waits on the socket for a game recording
+ * with "-xunix:<path>" (see "rec_play()").  "-ptext:<file>" instead prints
+ * the screen as it stood at the end as plain text (see "rec_replay()").
+ */
+
+#include "angband.h"
+
+#ifdef USE_REC
+
+#include "main.h"
+#include "log.h"
+
+#ifdef SET_UID
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif /* SET_UID */
+
+/*
+ * Stream version
+ */
+#define REC_VERSION 1
+
+/*
+ * Frames between keyframes
+ */
+#define REC_KEYFRAME 300
+
+/*
+ * Unchanged cells which may be folded into a span (cheaper than a new one)
+ */
+#define REC_GAP 4
+
+/*
+ * The term being recorded, and the hook we wrapped
+ */
+static term* rec_term = NULL;
+static errr (*rec_xtra_aux)(int n, int v) = NULL;
+
+/*
+ * Where the frames go -- a file, or a connected socket
+ */
+static FILE* rec_fff = NULL;
+static int rec_fd = -1;
+
+/*
+ * The screen as of the last frame
+ */
+static byte* rec_a = NULL;
+static char* rec_c = NULL;
+static int rec_w = 0;
+static int rec_h = 0;
+
+/*
+ * Frame buffer, big enough for the worst case frame
+ */
+static byte* rec_buf = NULL;
+static size_t rec_len = 0;
+
+/*
+ * Time the recording started, and frames since the last keyframe
+ */
+static u32b rec_start = 0;
+static int rec_count = 0;
+
+/*
+ * Append bytes to the frame buffer
+ */
+static void rec_byte(int b) { rec_buf[rec_len++] = (byte)b; }
+
+static void rec_u16b(u16b v)
+{
+    rec_byte(v & 0xFF);
+    rec_byte(v >> 8);
+}
+
+static void rec_u32b(u32b v)
+{
+    rec_u16b((u16b)(v & 0xFFFF));
+    rec_u16b((u16b)(v >> 16));
+}
+
+/*
+ * Send bytes on their way, returning false if the viewer has gone
+ */
+static bool rec_send(const byte* buf, size_t len)
+{
+    if (rec_fff)
+    {
+        if (fwrite(buf, 1, len, rec_fff) != len)
+            return (false);
+        return (fflush(rec_fff) == 0);
+    }
+
+#ifdef SET_UID
+
+    while (len)
+    {
+#ifdef MSG_NOSIGNAL
+        /* Never let a vanished viewer raise SIGPIPE (which saves and quits) */
+        ssize_t n = send(rec_fd, buf, len, MSG_NOSIGNAL);
+#else
+        ssize_t n = write(rec_fd, buf, len);
+#endif
+
+        if (n <= 0)
+            return (false);
+
+        buf += n;
+        len -= (size_t)n;
+    }
+
+#endif /* SET_UID */
+
+    return (true);
+}
+
+/*
+ * Stop recording, putting the wrapped hook back
+ */
+static void rec_stop(void)
+{
+    if (rec_term)
+        rec_term->xtra_hook = rec_xtra_aux;
+
+    if (rec_fff)
+        my_fclose(rec_fff);
+    if (rec_fd >= 0)
+        (void)fd_close(rec_fd);
+
+    rec_fff = NULL;
+    rec_fd = -1;
+    rec_term = NULL;
+
+    KILL(rec_a);
+    KILL(rec_c);
+    KILL(rec_buf);
+    rec_w = rec_h = 0;
+}
+
+/*
+ * Append a span of row "y", from "x" for "n" cells, and remember it
+ */
+static void rec_span(int y, int x, int n)
+{
+    const byte* ap = &rec_term->scr->a[y][x];
+    const char* cp = &rec_term->scr->c[y][x];
+    int i, k;
+
+    rec_byte(y);
+    rec_byte(x);
+    rec_byte(n);
+
+    for (i = 0; i < n; i++)
+        rec_byte(cp[i]);
+
+    /* Attributes, as runs */
+    for (i = 0; i < n; i = k)
+    {
+        for (k = i + 1; (k < n) && (ap[k] == ap[i]); k++) /* loop */
+            ;
+
+        rec_byte(k - i);
+        rec_byte(ap[i]);
+    }
+
+    /* Remember */
+    C_COPY(&rec_a[y * rec_w + x], ap, n, byte);
+    C_COPY(&rec_c[y * rec_w + x], cp, n, char);
+}
+
+/*
+ * Append the cursor state
+ */
+static void rec_cursor(void)
+{
+    term_win* scr = rec_term->scr;
+
+    rec_byte(scr->cx);
+    rec_byte(scr->cy);
+    rec_byte((scr->cv ? 0x01 : 0) | (scr->cu ? 0x02 : 0));
+}
+
+/*
+ * Record the screen as it now stands
+ */
+static void rec_frame(void)
+{
+    term_win* scr = rec_term->scr;
+    int w = MIN(rec_term->wid, 255);
+    int h = MIN(rec_term->hgt, 255);
+    int y;
+
+    /* New (or first) screen size */
+    if ((w != rec_w) || (h != rec_h))
+    {
+        KILL(rec_a);
+        KILL(rec_c);
+        KILL(rec_buf);
+
+        rec_w = w;
+        rec_h = h;
+
+        C_MAKE(rec_a, w * h, byte);
+        C_MAKE(rec_c, w * h, char);
+
+        /* Worst case is every cell changed, each with a new attribute */
+        C_MAKE(rec_buf, 16 + h * (3 + w * 3), byte);
+
+        rec_count = 0;
+    }
+
+    rec_len = 0;
+
+    /* Keyframe */
+    if (!rec_count)
+    {
+        rec_byte('K');
+        rec_u32b(clock_msec() - rec_start);
+        rec_byte(w);
+        rec_byte(h);
+        rec_cursor();
+
+        for (y = 0; y < h; y++)
+            rec_span(y, 0, w);
+    }
+
+    /* Delta */
+    else
+    {
+        size_t count_at;
+        int spans = 0;
+
+        rec_byte('D');
+        rec_u32b(clock_msec() - rec_start);
+        rec_cursor();
+
+        /* Span count (filled in below) */
+        count_at = rec_len;
+        rec_u16b(0);
+
+        for (y = 0; y < h; y++)
+        {
+            const byte* ap = scr->a[y];
+            const char* cp = scr->c[y];
+            const byte* oap = &rec_a[y * w];
+            const char* ocp = &rec_c[y * w];
+            int x = 0;
+
+            /* Unchanged row */
+            if (!memcmp(ap, oap, w) && !memcmp(cp, ocp, w))
+                continue;
+
+            while (x < w)
+            {
+                int x1, x2, gap;
+
+                /* Skip unchanged cells */
+                if ((ap[x] == oap[x]) && (cp[x] == ocp[x]))
+                {
+                    x++;
+                    continue;
+                }
+
+                /* Extend over changes, folding in short unchanged gaps */
+                x1 = x2 = x;
+                for (gap = 0, x++; (x < w) && (gap <= REC_GAP); x++)
+                {
+                    if ((ap[x] == oap[x]) && (cp[x] == ocp[x]))
+                    {
+                        gap++;
+                    }
+                    else
+                    {
+                        gap = 0;
+                        x2 = x;
+                    }
+                }
+
+                rec_span(y, x1, x2 - x1 + 1);
+                spans++;
+
+                x = x2 + 1;
+            }
+        }
+
+        rec_buf[count_at] = (byte)(spans & 0xFF);
+        rec_buf[count_at + 1] = (byte)(spans >> 8);
+    }
+
+    if (++rec_count >= REC_KEYFRAME)
+        rec_count = 0;
+
+    /* Send it, or give up on a vanished viewer */
+    if (!rec_send(rec_buf, rec_len))
+    {
+        log_warn("Screen recording stopped (write failed)");
+        rec_stop();
+    }
+}
+
+/*
+ * Wrapped "xtra_hook" for the recorded term
+ */
+static errr Term_xtra_rec(int n, int v)
+{
+    errr res = (*rec_xtra_aux)(n, v);
+
+    /* Record each flush of the screen */
+    if ((n == TERM_XTRA_FRESH) && (Term == rec_term))
+        rec_frame();
+
+    return (res);
+}
+
+/*
+ * Open a connection to a viewer listening on the Unix socket "path"
+ */
+static int rec_connect(cptr path)
+{
+#ifdef SET_UID
+
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return (-1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return (-1);
+
+    WIPE(&addr, struct sockaddr_un);
+    addr.sun_family = AF_UNIX;
+    my_strcpy(addr.sun_path, path, sizeof(addr.sun_path));
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        (void)fd_close(fd);
+        return (-1);
+    }
+
+    return (fd);
+
+#else /* SET_UID */
+
+    /* Unused parameter */
+    (void)path;
+
+    return (-1);
+
+#endif /* SET_UID */
+}
+
+/*
+ * Start recording term "t" to "dest", which is a file name, or "unix:"
+ * followed by the path of a listening socket.
+ */
+errr init_rec(term* t, cptr dest)
+{
+    static const byte magic[7] = { 'S', 'I', 'L', 'R', 'E', 'C', REC_VERSION };
+
+    /* Already recording, or nothing to wrap */
+    if (rec_term || !t || !t->xtra_hook)
+        return (-1);
+
+    if (prefix(dest, "unix:"))
+    {
+        rec_fd = rec_connect(dest + 5);
+        if (rec_fd < 0)
+            return (-1);
+    }
+    else
+    {
+        char buf[1024];
+
+        path_parse(buf, sizeof(buf), dest);
+
+        rec_fff = my_fopen(buf, "wb");
+        if (!rec_fff)
+            return (-1);
+    }
+
+    rec_term = t;
+    rec_xtra_aux = t->xtra_hook;
+    rec_start = clock_msec();
+    rec_count = 0;
+
+    if (!rec_send(magic, sizeof(magic)))
+    {
+        rec_stop();
+        return (-1);
+    }
+
+    /* Wrap the hook */
+    t->xtra_hook = Term_xtra_rec;
+
+    return (0);
+}
+
+/*
+ * Reading a recording back: the stream, and the screen it describes
+ */
+static FILE* rec_in = NULL;
+static bool rec_short = false;
+static byte* rec_ra = NULL;
+static char* rec_rc = NULL;
+static int rec_rw = 0;
+static int rec_rh = 0;
+static int rec_rcx = 0;
+static int rec_rcy = 0;
+static int rec_rflags = 0;
+
+static int rec_get_byte(void)
+{
+    int b = getc(rec_in);
+
+    if (b == EOF)
+    {
+        rec_short = true;
+        return (0);
+    }
+
+    return (b);
+}
+
+static u16b rec_get_u16b(void)
+{
+    u16b v = (u16b)rec_get_byte();
+
+    return (v | (u16b)(rec_get_byte() << 8));
+}
+
+static u32b rec_get_u32b(void)
+{
+    u32b v = rec_get_u16b();
+
+    return (v | ((u32b)rec_get_u16b() << 16));
+}
+
+/*
+ * Read a span onto the screen, returning false if it does not fit
+ */
+static bool rec_get_span(void)
+{
+    int y = rec_get_byte();
+    int x = rec_get_byte();
+    int n = rec_get_byte();
+    int i, k, a;
+
+    if ((y >= rec_rh) || (x + n > rec_rw))
+        return (false);
+
+    for (i = 0; i < n; i++)
+        rec_rc[y * rec_rw + x + i] = (char)rec_get_byte();
+
+    /* Attributes, as runs */
+    for (i = 0; i < n; i += k)
+    {
+        k = rec_get_byte();
+        a = rec_get_byte();
+
+        if (!k || (i + k > n) || rec_short)
+            return (false);
+
+        memset(&rec_ra[y * rec_rw + x + i], a, k);
+    }
+
+    return (!rec_short);
+}
+
+/*
+ * Read the next frame onto the screen, and the time it was recorded at.
+ *
+ * Returns 1 for a frame, 0 at the end of the recording (a frame cut short
+ * by the game quitting counts as the end), and -1 if the recording is
+ * damaged.
+ */
+static int rec_get_frame(u32b* when)
+{
+    int tag = getc(rec_in);
+    int spans, i;
+
+    if (tag == EOF)
+        return (0);
+
+    *when = rec_get_u32b();
+
+    if (tag == 'K')
+    {
+        int w = rec_get_byte();
+        int h = rec_get_byte();
+
+        /* New screen */
+        if ((w != rec_rw) || (h != rec_rh) || !rec_rc)
+        {
+            KILL(rec_ra);
+            KILL(rec_rc);
+
+            rec_rw = w;
+            rec_rh = h;
+
+            C_MAKE(rec_ra, w * h + 1, byte);
+            C_MAKE(rec_rc, w * h + 1, char);
+        }
+
+        spans = h;
+    }
+    else if ((tag == 'D') && rec_rc)
+    {
+        spans = -1;
+    }
+    else
+    {
+        return (-1);
+    }
+
+    rec_rcx = rec_get_byte();
+    rec_rcy = rec_get_byte();
+    rec_rflags = rec_get_byte();
+
+    if (spans < 0)
+        spans = rec_get_u16b();
+
+    for (i = 0; i < spans; i++)
+    {
+        if (!rec_get_span())
+            break;
+    }
+
+    if (rec_short)
+        return (0);
+
+    return ((i < spans) ? -1 : 1);
+}
+
+#ifdef SET_UID
+
+/*
+ * Wait on the Unix socket "path" for a game to record to us
+ */
+static FILE* rec_listen(cptr path)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    FILE* fff;
+    int fd, conn;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return (NULL);
+
+    /* Clear away a socket left over from before (but nothing else) */
+    if (!stat(path, &st) && S_ISSOCK(st.st_mode))
+        (void)unlink(path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return (NULL);
+
+    WIPE(&addr, struct sockaddr_un);
+    addr.sun_family = AF_UNIX;
+    my_strcpy(addr.sun_path, path, sizeof(addr.sun_path));
+
+    if ((bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+        || (listen(fd, 1) < 0))
+    {
+        (void)fd_close(fd);
+        return (NULL);
+    }
+
+    conn = accept(fd, NULL, NULL);
+
+    (void)fd_close(fd);
+    (void)unlink(path);
+
+    if (conn < 0)
+        return (NULL);
+
+    fff = fdopen(conn, "rb");
+    if (!fff)
+        (void)fd_close(conn);
+
+    return (fff);
+}
+
+#endif /* SET_UID */
+
+/*
+ * Start reading the recording "src" -- a file name, or "unix:" followed by
+ * the path of a socket to wait on for a game to record to.  Returns -1 if
+ * it can't be read, and -2 if it is not a recording.
+ */
+static errr rec_open(cptr src)
+{
+    static const byte magic[7] = { 'S', 'I', 'L', 'R', 'E', 'C', REC_VERSION };
+
+    char buf[1024];
+    int i;
+
+    rec_short = false;
+
+    if (prefix(src, "unix:"))
+    {
+#ifdef SET_UID
+        rec_in = rec_listen(src + 5);
+#endif /* SET_UID */
+    }
+    else
+    {
+        path_parse(buf, sizeof(buf), src);
+        rec_in = my_fopen(buf, "rb");
+    }
+
+    if (!rec_in)
+        return (-1);
+
+    for (i = 0; i < (int)sizeof(magic); i++)
+    {
+        if (rec_get_byte() != magic[i])
+            return (-2);
+    }
+
+    return (0);
+}
+
+/*
+ * Stop reading a recording
+ */
+static void rec_close(void)
+{
+    if (rec_in)
+        (void)fclose(rec_in);
+
+    rec_in = NULL;
+
+    KILL(rec_ra);
+    KILL(rec_rc);
+    rec_rw = rec_rh = 0;
+}
+
+/*
+ * Play back the recording in the file "src", and print the screen as it
+ * stands after the last frame to "out", a line for each row with trailing
+ * blanks removed.  Returns -1 if the file can't be read, -2 if it is not a
+ * recording, and -3 if it is damaged (a recording cut short by the game
+ * quitting mid-frame stops at the last whole frame).
+ */
+errr rec_replay(cptr src, FILE* out)
+{
+    char* last = NULL;
+    int w = 0, h = 0;
+    int y, x, got;
+    u32b when;
+    errr res;
+
+    res = rec_open(src);
+
+    /* Keep a copy of each whole frame */
+    while (!res && ((got = rec_get_frame(&when)) != 0))
+    {
+        if (got < 0)
+        {
+            res = -3;
+            break;
+        }
+
+        if ((w != rec_rw) || (h != rec_rh))
+        {
+            KILL(last);
+
+            w = rec_rw;
+            h = rec_rh;
+
+            C_MAKE(last, w * h + 1, char);
+        }
+
+        C_COPY(last, rec_rc, w * h, char);
+    }
+
+    rec_close();
+
+    /* Print the screen */
+    if (!res && last)
+    {
+        for (y = 0; y < h; y++)
+        {
+            char* row = &last[y * w];
+
+            for (x = w; (x > 0) && (row[x - 1] == ' '); x--) /* loop */
+                ;
+
+            (void)fwrite(row, 1, x, out);
+            putc('\n', out);
+        }
+    }
+
+    KILL(last);
+
+    return (res);
+}
+
+/*
+ * Longest pause between frames kept when playing a recording (ms)
+ */
+#define REC_IDLE_MAX 2000
+
+/*
+ * Show the screen read so far on the current term
+ */
+static void rec_show(void)
+{
+    int w = MIN(rec_rw, Term->wid);
+    int h = MIN(rec_rh, Term->hgt);
+    int y, x, k;
+
+    for (y = 0; y < h; y++)
+    {
+        const byte* ap = &rec_ra[y * rec_rw];
+        const char* cp = &rec_rc[y * rec_rw];
+
+        /* Runs of one attribute */
+        for (x = 0; x < w; x = k)
+        {
+            for (k = x + 1; (k < w) && (ap[k] == ap[x]); k++) /* loop */
+                ;
+
+            Term_putstr(x, y, k - x, ap[x], &cp[x]);
+        }
+    }
+
+    if ((rec_rcx < w) && (rec_rcy < h))
+        (void)Term_gotoxy(rec_rcx, rec_rcy);
+
+    (void)Term_set_cursor((rec_rflags & 0x01) ? true : false);
+
+    Term_fresh();
+}
+
+/*
+ * Wait "msec" milliseconds between frames, dealing with any keys: escape
+ * (or 'q') stops, space pauses and resumes, and while paused any other key
+ * steps on one frame.  Returns false to stop.
+ */
+static bool rec_wait(int msec, bool* paused)
+{
+    while (true)
+    {
+        char ch;
+
+        /* Deal with any key */
+        if (!Term_inkey(&ch, false, true))
+        {
+            if ((ch == ESCAPE) || (ch == 'q'))
+                return (false);
+
+            if (ch == ' ')
+                *paused = !*paused;
+            else if (*paused)
+                return (true);
+
+            continue;
+        }
+
+        if ((msec <= 0) && !*paused)
+            return (true);
+
+        (void)Term_xtra(TERM_XTRA_DELAY, 10);
+
+        if (!*paused)
+            msec -= 10;
+    }
+}
+
+/*
+ * Play the recording "src" (see "rec_open()") on the current term.
+ *
+ * A recording from a file is played at the pace it was recorded at, with
+ * long idle spells cut short.  One from a socket is shown as it arrives,
+ * so another process can watch a game being played.  Returns as for
+ * "rec_replay()".
+ */
+errr rec_play(cptr src)
+{
+    bool live = prefix(src, "unix:");
+    bool paused = false;
+    bool first = true;
+    u32b last = 0;
+    u32b when;
+    int got = 0;
+    errr res;
+    char ch;
+
+    Term_clear();
+
+    if (live)
+    {
+        Term_putstr(0, 0, -1, TERM_WHITE, "Waiting for a game to record to ");
+        Term_addstr(-1, TERM_WHITE, src + 5);
+        Term_fresh();
+    }
+
+    res = rec_open(src);
+
+    while (!res && ((got = rec_get_frame(&when)) > 0))
+    {
+        /* Keep to the recorded pace (a live game keeps its own) */
+        if (!rec_wait((live || first) ? 0 : (int)MIN(when - last, REC_IDLE_MAX),
+                &paused))
+        {
+            break;
+        }
+
+        first = false;
+        last = when;
+
+        rec_show();
+    }
+
+    rec_close();
+
+    if (!res && (got < 0))
+        res = -3;
+
+    /* Let the last screen be seen */
+    if (!res && (got <= 0))
+    {
+        Term_putstr(0, Term->hgt - 1, -1, TERM_WHITE,
+            "End of the recording -- press any key");
+        Term_fresh();
+        (void)Term_inkey(&ch, true, true);
+    }
+
+    return (res);
+}
+
+#endif /* USE_REC */
@@ -369,6 +369,19 @@ int main(int argc, char* argv[])
 
     cptr mstr = NULL;
 
+    cptr level_key = NULL;
+
+    cptr levstat_spec = NULL;
+
+    cptr sim_spec = NULL;
+
+    cptr dump_dest = NULL;
+
+#ifdef USE_REC
+    cptr rec_dest = NULL;
+    cptr rec_src = NULL;
+#endif /* USE_REC */
+
     bool args = true;
 
     /* Initialize character_icky to ensure it starts at 0 */
@@ -537,6 +550,17 @@ init_logger(true);
             continue;
         }
 
+        case 't':
+        case 'T':
+        {
+            if (!*arg)
+                goto usage;
+            fresh_rate = atoi(arg);
+            if (fresh_rate < 0)
+                fresh_rate = 0;
+            continue;
+        }
+
         case 'u':
         case 'U':
         {
@@ -560,6 +584,62 @@ init_logger(true);
             continue;
         }
 
+        case 'c':
+        case 'C':
+        {
+            if (!*arg)
+                goto usage;
+            levstat_spec = arg;
+            continue;
+        }
+
+        case 'b':
+        case 'B':
+        {
+            if (!*arg)
+                goto usage;
+            sim_spec = arg;
+            continue;
+        }
+
+        case 'e':
+        case 'E':
+        {
+            if (!*arg)
+                goto usage;
+            dump_dest = arg;
+            continue;
+        }
+
+        case 'l':
+        case 'L':
+        {
+            if (!*arg)
+                goto usage;
+            level_key = arg;
+            continue;
+        }
+
+#ifdef USE_REC
+        case 'x':
+        case 'X':
+        {
+            if (!*arg)
+                goto usage;
+            rec_dest = arg;
+            continue;
+        }
+
+        case 'p':
+        case 'P':
+        {
+            if (!*arg)
+                goto usage;
+            rec_src = arg;
+            continue;
+        }
+#endif /* USE_REC */
+
         case 'd':
         case 'D':
         {
@@ -589,8 +669,21 @@ init_logger(true);
             puts("  -o       Request original keyset (default)");
             puts("  -r       Request rogue-like keyset");
             puts("  -s<num>  Show <num> high scores (default: 10)");
+            puts("  -t<fps>  Refresh at most <fps> times a second (0: no limit)");
             puts("  -u<who>  Use your <who> savefile");
             puts("  -d<def>  Define a 'lib' dir sub-path");
+            puts("  -l<key>  Start on the level with key <key> (see the log)");
+            puts("  -c<d1>-<d2>:<n>[:<jobs>[:<seed>]]  Generate <n> levels at each");
+            puts("           depth for statistics (see levstat.c), then quit");
+            puts("  -b<r1>-<r2>:<n>[:<seed>[:a]]  Simulate <n> fights with each");
+            puts("           race for the character of -u (see sim.c), then quit");
+            puts("  -e<dst>  Export each level generated to file <dst> (or");
+            puts("           bin:<file> for binary, see levdump.c)");
+#ifdef USE_REC
+            puts("  -x<dst>  Record the screen to file <dst> (or unix:<socket>)");
+            puts("  -p<src>  Play back recording <src> (or watch unix:<socket>,");
+            puts("           or print its last screen with text:<file>)");
+#endif /* USE_REC */
             puts("  -m<sys>  use Module <sys>, where <sys> can be:");
 
             /* Print the name and help for each available module */
@@ -620,6 +713,38 @@ init_logger(true);
     /* Install "quit" hook */
     quit_aux = quit_hook;
 
+    /* Generate levels for statistics, with no display, and quit */
+    if (levstat_spec)
+    {
+        init_levstat_term();
+        init_angband();
+        if (dump_dest && gen_dump_open(dump_dest))
+            quit_fmt("Unable to export levels to '%s'!", dump_dest);
+        levstat_run(levstat_spec);
+        cleanup_angband();
+        quit(NULL);
+    }
+
+    /* Simulate fights, with no display, and quit */
+    if (sim_spec)
+    {
+        init_levstat_term();
+        init_angband();
+        sim_run(sim_spec);
+        cleanup_angband();
+        quit(NULL);
+    }
+
+#ifdef USE_REC
+    /* Print the end of a recording, with no display, and quit */
+    if (rec_src && prefix(rec_src, "text:"))
+    {
+        if (rec_replay(rec_src + 5, stdout))
+            quit_fmt("Unable to play back the recording '%s'!", rec_src);
+        quit(NULL);
+    }
+#endif /* USE_REC */
+
     /* Try the modules in the order specified by modules[] */
     for (i = 0; i < (int)N_ELEMENTS(modules); i++)
     {
@@ -640,12 +765,39 @@ init_logger(true);
         quit(
             "Unable to prepare any 'display module' (such as 'x11' or 'gcu')!");
 
+#ifdef USE_REC
+    /* Play back a recording and quit */
+    if (rec_src)
+    {
+        if (rec_play(rec_src))
+            quit_fmt("Unable to play back the recording '%s'!", rec_src);
+        quit(NULL);
+    }
+
+    /* Record the main screen if requested */
+    if (rec_dest && init_rec(angband_term[0], rec_dest))
+        quit_fmt("Unable to record the screen to '%s'!", rec_dest);
+#endif /* USE_REC */
+
     /* Catch nasty signals */
     signals_init();
 
     /* Initialize */
     init_angband();
 
+    /* Export each level generated if requested */
+    if (dump_dest && gen_dump_open(dump_dest))
+        quit_fmt("Unable to export levels to '%s'!", dump_dest);
+
+    /* Build a recorded level once the character is ready */
+    if (level_key)
+    {
+        if (!gen_key_parse(level_key, &gen_replay))
+            quit_fmt("Bad level key '%s'", level_key);
+
+        gen_replay_set = true;
+    }
+
     /* Hack -- If requested, display scores and quit */
     if (show_score > 0)
         display_scores(0, show_score);
@@ -28,6 +28,10 @@ extern errr init_ami(int argc, char** argv);
 extern errr init_vme(int argc, char** argv);
 extern errr init_vcs(int argc, char** argv);
 
+extern errr init_rec(term* t, cptr dest);
+extern errr rec_replay(cptr src, FILE* out);
+extern errr rec_play(cptr src);
+
 extern const char help_xpj[];
 extern const char help_xaw[];
 extern const char help_x11[];
@@ -600,100 +600,17 @@ bool cave_exist_mon(
 }
 
 /*
- * Can the monster enter this grid?  How easy is it for them to do so?
- *
- * Returns the percentage chance of success.
+ * How easy is it for the monster to get over the terrain of this grid, given
+ * its chance "move_chance" of getting past whoever is standing there?
  *
- * The code that uses this function sometimes assumes that it will never
- * return a value greater than 100.
- *
- * The usage of level to determine whether one monster can push past
- * another is a tad iffy, but ensures that orc soldiers can always
- * push past other orc soldiers.
+ * This is the part of "cave_passable_mon()" that looks at the terrain.
  */
-int cave_passable_mon(monster_type* m_ptr, int y, int x, bool* bash)
+static int cave_passable_feat(
+    monster_type* m_ptr, int y, int x, int move_chance, bool* bash)
 {
     monster_race* r_ptr = &r_info[m_ptr->r_idx];
 
-    /* Assume nothing in the grid other than the terrain hinders movement */
-    int move_chance = 100;
-
-    int feat;
-
-    /* Check Bounds */
-    if (!in_bounds(y, x))
-        return (0);
-
-    /* Check location */
-    feat = cave_feat[y][x];
-
-    /* Permanent walls are never passable */
-    if (feat == FEAT_WALL_PERM)
-        return (0);
-
-    /* The grid is occupied by the player. */
-    if (cave_m_idx[y][x] < 0)
-    {
-        /* Monster has no melee blows - character's grid is off-limits. */
-        if (r_ptr->flags1 & (RF1_NEVER_BLOW))
-            return (0);
-
-        /* Any monster with melee blows can attack the character. */
-        else
-            return (100);
-    }
-
-    /* The grid is occupied by a monster. */
-    else if (cave_m_idx[y][x] > 0)
-    {
-        monster_type* n_ptr = &mon_list[cave_m_idx[y][x]];
-        monster_race* nr_ptr = &r_info[n_ptr->r_idx];
-
-        /* Some creatures can kill weaker monsters */
-        if ((r_ptr->flags2 & (RF2_KILL_BODY))
-            && (!(nr_ptr->flags1 & (RF1_UNIQUE)))
-            && (r_ptr->level > nr_ptr->level))
-        {
-            move_chance = 100;
-        }
-
-        /* All can attempt to push past monsters that can move */
-        else if (!(nr_ptr->flags1 & (RF1_NEVER_MOVE))
-            && !(nr_ptr->flags1 & (RF1_HIDDEN_MOVE)))
-        {
-            // It is easy to push past unwary or sleeping monsters
-            if ((n_ptr->alertness < ALERTNESS_ALERT)
-                && (m_ptr->wandering_idx != n_ptr->wandering_idx))
-                move_chance = 80;
-
-            // It is easy for non-fleeing monsters to push past fleeing monsters
-            else if ((n_ptr->stance == STANCE_FLEEING)
-                && (m_ptr->stance != STANCE_FLEEING))
-                move_chance = 80;
-
-            // It is easy for fleeing monsters to push past non-fleeing monsters
-            else if ((n_ptr->stance != STANCE_FLEEING)
-                && (m_ptr->stance == STANCE_FLEEING))
-                move_chance = 80;
-
-            // It is easy to push past weaker monsters
-            else if (r_ptr->level > nr_ptr->level)
-                move_chance = 80;
-
-            // It is quite hard to push past monsters of equal strength
-            else if (r_ptr->level == nr_ptr->level)
-                move_chance = 20;
-
-            // It is very difficult to move past alert, unafraid, stronger
-            // monsters
-            else
-                move_chance = 10;
-        }
-
-        /* Cannot do anything to clear away the other monster */
-        else
-            return (0);
-    }
+    int feat = cave_feat[y][x];
 
     /* Glyphs */
     if (feat == FEAT_GLYPH)
@@ -918,6 +835,124 @@ int cave_passable_mon(monster_type* m_ptr, int y, int x, bool* bash)
     }
 }
 
+/*
+ * Can the monster enter this grid?  How easy is it for them to do so?
+ *
+ * Returns the percentage chance of success.
+ *
+ * The code that uses this function sometimes assumes that it will never
+ * return a value greater than 100.
+ *
+ * The usage of level to determine whether one monster can push past
+ * another is a tad iffy, but ensures that orc soldiers can always
+ * push past other orc soldiers.
+ */
+int cave_passable_mon(monster_type* m_ptr, int y, int x, bool* bash)
+{
+    monster_race* r_ptr = &r_info[m_ptr->r_idx];
+
+    /* Assume nothing in the grid other than the terrain hinders movement */
+    int move_chance = 100;
+
+    int feat;
+
+    /* Check Bounds */
+    if (!in_bounds(y, x))
+        return (0);
+
+    /* Check location */
+    feat = cave_feat[y][x];
+
+    /* Permanent walls are never passable */
+    if (feat == FEAT_WALL_PERM)
+        return (0);
+
+    /* The grid is occupied by the player. */
+    if (cave_m_idx[y][x] < 0)
+    {
+        /* Monster has no melee blows - character's grid is off-limits. */
+        if (r_ptr->flags1 & (RF1_NEVER_BLOW))
+            return (0);
+
+        /* Any monster with melee blows can attack the character. */
+        else
+            return (100);
+    }
+
+    /* The grid is occupied by a monster. */
+    else if (cave_m_idx[y][x] > 0)
+    {
+        monster_type* n_ptr = &mon_list[cave_m_idx[y][x]];
+        monster_race* nr_ptr = &r_info[n_ptr->r_idx];
+
+        /* Some creatures can kill weaker monsters */
+        if ((r_ptr->flags2 & (RF2_KILL_BODY))
+            && (!(nr_ptr->flags1 & (RF1_UNIQUE)))
+            && (r_ptr->level > nr_ptr->level))
+        {
+            move_chance = 100;
+        }
+
+        /* All can attempt to push past monsters that can move */
+        else if (!(nr_ptr->flags1 & (RF1_NEVER_MOVE))
+            && !(nr_ptr->flags1 & (RF1_HIDDEN_MOVE)))
+        {
+            // It is easy to push past unwary or sleeping monsters
+            if ((n_ptr->alertness < ALERTNESS_ALERT)
+                && (m_ptr->wandering_idx != n_ptr->wandering_idx))
+                move_chance = 80;
+
+            // It is easy for non-fleeing monsters to push past fleeing monsters
+            else if ((n_ptr->stance == STANCE_FLEEING)
+                && (m_ptr->stance != STANCE_FLEEING))
+                move_chance = 80;
+
+            // It is easy for fleeing monsters to push past non-fleeing monsters
+            else if ((n_ptr->stance != STANCE_FLEEING)
+                && (m_ptr->stance == STANCE_FLEEING))
+                move_chance = 80;
+
+            // It is easy to push past weaker monsters
+            else if (r_ptr->level > nr_ptr->level)
+                move_chance = 80;
+
+            // It is quite hard to push past monsters of equal strength
+            else if (r_ptr->level == nr_ptr->level)
+                move_chance = 20;
+
+            // It is very difficult to move past alert, unafraid, stronger
+            // monsters
+            else
+                move_chance = 10;
+        }
+
+        /* Cannot do anything to clear away the other monster */
+        else
+            return (0);
+    }
+
+    return (cave_passable_feat(m_ptr, y, x, move_chance, bash));
+}
+
+/*
+ * As cave_passable_mon(), but ignoring any monster or player in the grid.
+ *
+ * Wandering flows are built with this so that they stay good as monsters
+ * move around, leaving "get_move_wander()" to deal with whoever is in the way.
+ */
+int cave_passable_terrain(monster_type* m_ptr, int y, int x, bool* bash)
+{
+    /* Check Bounds */
+    if (!in_bounds(y, x))
+        return (0);
+
+    /* Permanent walls are never passable */
+    if (cave_feat[y][x] == FEAT_WALL_PERM)
+        return (0);
+
+    return (cave_passable_feat(m_ptr, y, x, 100, bash));
+}
+
 /*
  *  Determine the next move for an unwary wandering monster
  */
@@ -932,6 +967,7 @@ static bool get_move_wander(monster_type* m_ptr, int* ty, int* tx)
     monster_race* r_ptr = &r_info[m_ptr->r_idx];
     bool no_move = false;
     bool random_move = false;
+    bool bash = false;
 
     /* Monster location */
     y1 = m_ptr->fy;
@@ -1186,6 +1222,18 @@ static bool get_move_wander(monster_type* m_ptr, int* ty, int* tx)
 
             dist = flow_dist(m_ptr->wandering_idx, y, x);
 
+            // the flow only knows the terrain, so add the cost of getting
+            // past whoever is standing there now
+            if ((dist < FLOW_MAX_DIST) && (cave_m_idx[y][x] != 0))
+            {
+                int chance = cave_passable_mon(m_ptr, y, x, &bash);
+
+                if (chance == 0)
+                    continue;
+
+                dist += (100 / chance) - 1;
+            }
+
             // ignore grids that are further than the current favourite
             if (closest < dist)
                 continue;
@@ -1237,9 +1285,10 @@ static bool get_move_wander(monster_type* m_ptr, int* ty, int* tx)
  * less embarrassing than was the case before.  In particular, it makes
  * monsters great at not being seen.
  *
- * This function is fairly expensive.  Call it only when necessary.
+ * This function is fairly expensive.  It is now only used as a fallback
+ * for monsters that the shared safety map can't help (see "find_safety()").
  */
-static bool find_safety(monster_type* m_ptr, int* ty, int* tx)
+static bool find_safety_local(monster_type* m_ptr, int* ty, int* tx)
 {
     int i, j, d;
 
@@ -1485,6 +1534,160 @@ static bool find_safety(monster_type* m_ptr, int* ty, int* tx)
     return (false);
 }
 
+/*
+ * Is the grid next to the player?
+ */
+static bool next_to_player(int y, int x)
+{
+    return (distance(y, x, p_ptr->py, p_ptr->px) <= 1);
+}
+
+/*
+ * "Do not be seen", using the shared safety maps.
+ *
+ * The safety maps (see "update_safety()") hold the distance from each grid
+ * to the nearest hiding place, so a monster only needs to look at its
+ * neighbours to find the way downhill.  Intelligent monsters which aren't
+ * tied to their territory use the map in which stairs count as hiding
+ * places, as they can escape by them.  Among equally good steps, prefer
+ * those that are not next to the character and then those that are further
+ * away from the character's noise, picking at random between the rest.
+ *
+ * The monster takes the first step itself and targets the hiding place at
+ * the bottom of the slope.  The maps are built for a typical monster, so
+ * the whole way down is checked against this one.  If the maps are of no
+ * use to it (it is out of range, it moves through walls, or the way down
+ * is closed to it) we fall back on the old local search.  A monster which
+ * is already on a hiding place still moves on, to the best of its
+ * neighbours, as a grid that is merely unlit may be in plain view.
+ */
+static bool find_safety(monster_type* m_ptr, int* ty, int* tx)
+{
+    monster_race* r_ptr = &r_info[m_ptr->r_idx];
+    byte(*safety)[MAX_DUNGEON_WID] = cave_safety;
+    int i, y, x;
+    int here;
+    int best_y = 0, best_x = 0;
+    int best_safety = FLOW_MAX_DIST;
+    int best_noise = -1;
+    bool best_adjacent = true;
+    bool dummy;
+
+    /* Monsters that move through walls have hiding places of their own */
+    if (r_ptr->flags2 & (RF2_PASS_WALL | RF2_KILL_WALL))
+        return (find_safety_local(m_ptr, ty, tx));
+
+    /* Rebuild the shared maps if the player's view has changed */
+    if (safety_stale)
+        update_safety();
+
+    /* Intelligent monsters can also flee by the stairs */
+    if ((r_ptr->flags2 & (RF2_SMART)) && !(r_ptr->flags2 & (RF2_TERRITORIAL)))
+        safety = cave_safety_stair;
+
+    here = safety[m_ptr->fy][m_ptr->fx];
+
+    /* Find the best step downhill */
+    for (i = 0; i < 8; i++)
+    {
+        int noise;
+        bool adjacent;
+
+        y = m_ptr->fy + ddy_ddd[i];
+        x = m_ptr->fx + ddx_ddd[i];
+
+        if (!in_bounds(y, x))
+            continue;
+
+        /* Must get closer to a hiding place (or stay hidden) */
+        if (((here > 0) && (safety[y][x] >= here))
+            || (safety[y][x] > best_safety))
+            continue;
+
+        /* Must be able to get there */
+        if (!cave_passable_mon(m_ptr, y, x, &dummy))
+            continue;
+
+        adjacent = next_to_player(y, x);
+        noise = flow_dist(FLOW_PLAYER_NOISE, y, x);
+
+        /* Break ties */
+        if (safety[y][x] == best_safety)
+        {
+            if (adjacent && !best_adjacent)
+                continue;
+            if ((adjacent == best_adjacent) && (noise < best_noise))
+                continue;
+            if ((adjacent == best_adjacent) && (noise == best_noise)
+                && one_in_(2))
+                continue;
+        }
+
+        best_safety = safety[y][x];
+        best_adjacent = adjacent;
+        best_noise = noise;
+        best_y = y;
+        best_x = x;
+    }
+
+    /* The map can't help this monster */
+    if (best_safety >= FLOW_MAX_DIST)
+        return (find_safety_local(m_ptr, ty, tx));
+
+    /* Follow the slope down to the hiding place itself */
+    y = best_y;
+    x = best_x;
+    while (safety[y][x] > 0)
+    {
+        int next_y = -1, next_x = -1;
+
+        best_noise = -1;
+
+        for (i = 0; i < 8; i++)
+        {
+            int yy = y + ddy_ddd[i];
+            int xx = x + ddx_ddd[i];
+            int noise;
+
+            if (!in_bounds(yy, xx))
+                continue;
+
+            if (safety[yy][xx] != safety[y][x] - 1)
+                continue;
+
+            /* The way must be open to this monster */
+            if (!cave_passable_mon(m_ptr, yy, xx, &dummy))
+                continue;
+
+            noise = flow_dist(FLOW_PLAYER_NOISE, yy, xx);
+
+            if ((noise > best_noise) || ((noise == best_noise) && one_in_(2)))
+            {
+                best_noise = noise;
+                next_y = yy;
+                next_x = xx;
+            }
+        }
+
+        /* The way down is closed to this monster */
+        if (next_y < 0)
+            return (find_safety_local(m_ptr, ty, tx));
+
+        y = next_y;
+        x = next_x;
+    }
+
+    /* Move towards the hiding place */
+    *ty = best_y;
+    *tx = best_x;
+
+    /* Target the hiding place */
+    m_ptr->target_y = y;
+    m_ptr->target_x = x;
+
+    return (true);
+}
+
 /*
  * Helper function for monsters that want to retreat from the character.
  * Used for any monster that is terrified, frightened, is looking for a
@@ -1994,25 +2197,74 @@ static void get_move_advance(monster_type* m_ptr, int* ty, int* tx)
     }
 }
 
-// This determines how vulnerable the player is to monster attacks
-// It combines elements for available spaces to attack from and for
-// the player's condition and other monsters attacking
-//
-// I'm sure it could be further improved
+/*
+ * Memo of the parts of "calc_vulnerability()" and "adj_mon_count()" that only
+ * depend on the grids around the player.
+ *
+ * Every approaching monster asks the same questions about the player's
+ * surroundings, so the answers are remembered for the rest of the game turn.
+ * The memo is keyed by the turn and the player's location, and is thrown away
+ * whenever a monster or feature in the player's 3x3 neighbourhood changes
+ * (see "note_player_neighbour()").
+ */
+static bool vuln_memo_valid = false;
+static s32b vuln_memo_turn;
+static int vuln_memo_y;
+static int vuln_memo_x;
+static s16b vuln_memo[10];
+static s16b vuln_memo_adj;
 
-static int calc_vulnerability(int fy, int fx)
+/*
+ * Make sure the memo belongs to the current turn and player location
+ */
+static void check_vuln_memo(void)
+{
+    int i;
+
+    if (vuln_memo_valid && (vuln_memo_turn == turn)
+        && (vuln_memo_y == p_ptr->py) && (vuln_memo_x == p_ptr->px))
+        return;
+
+    vuln_memo_valid = true;
+    vuln_memo_turn = turn;
+    vuln_memo_y = p_ptr->py;
+    vuln_memo_x = p_ptr->px;
+
+    for (i = 0; i < 10; i++)
+        vuln_memo[i] = -1;
+    vuln_memo_adj = -1;
+}
+
+/*
+ * Forget the memo if a grid next to (or under) the player has changed
+ */
+void note_player_neighbour(int y, int x)
+{
+    if (vuln_memo_valid && (ABS(y - vuln_memo_y) <= 1)
+        && (ABS(x - vuln_memo_x) <= 1))
+    {
+        vuln_memo_valid = false;
+    }
+}
+
+/*
+ * Forget the memo (when the player is moved to another level)
+ */
+void wipe_vuln_memo(void)
+{
+    vuln_memo_valid = false;
+}
+
+/*
+ * The part of the player's vulnerability that comes from the open squares and
+ * attacking monsters around the player, as seen from the direction "dir".
+ */
+static int calc_vulnerability_grids(int dir)
 {
     int py = p_ptr->py;
     int px = p_ptr->px;
     int dy, dx;
-    int dir;
-    int vulnerability;
-
-    // reset the vulnerability
-    vulnerability = 0;
-
-    // determine the main direction from the player to the monster
-    dir = rough_direction(py, px, fy, fx);
+    int vulnerability = 0;
 
     // extract the deltas from the direction
     dy = ddy[dir];
@@ -2094,6 +2346,30 @@ static int calc_vulnerability(int fy, int fx)
             vulnerability += 2; // direction 8
     }
 
+    return vulnerability;
+}
+
+// This determines how vulnerable the player is to monster attacks
+// It combines elements for available spaces to attack from and for
+// the player's condition and other monsters attacking
+//
+// I'm sure it could be further improved
+
+static int calc_vulnerability(int fy, int fx)
+{
+    int dir;
+    int vulnerability;
+
+    // determine the main direction from the player to the monster
+    dir = rough_direction(p_ptr->py, p_ptr->px, fy, fx);
+
+    // the surroundings are the same for every monster in this direction
+    check_vuln_memo();
+    if (vuln_memo[dir] < 0)
+        vuln_memo[dir] = calc_vulnerability_grids(dir);
+
+    vulnerability = vuln_memo[dir];
+
     if (!p_ptr->active_ability[S_WIL][WIL_FORMIDABLE])
     {
         // Take player's health into account
@@ -2187,6 +2463,14 @@ int adj_mon_count(int y, int x)
     int xx, yy;
     int count = 0;
 
+    // the count around the player is asked for by every nearby monster
+    if ((y == p_ptr->py) && (x == p_ptr->px))
+    {
+        check_vuln_memo();
+        if (vuln_memo_adj >= 0)
+            return (vuln_memo_adj);
+    }
+
     for (yy = -1; yy <= +1; yy++)
     {
         for (xx = -1; xx <= +1; xx++)
@@ -2201,6 +2485,9 @@ int adj_mon_count(int y, int x)
         }
     }
 
+    if ((y == p_ptr->py) && (x == p_ptr->px))
+        vuln_memo_adj = count;
+
     return (count);
 }
 
@@ -4909,10 +5196,11 @@ static void process_monster(monster_type* m_ptr)
         }
     }
 
-    // need to update view if the monster affects light and is close enough
+    // need to update the light if the monster affects light and is close
+    // enough
     if ((r_ptr->light != 0) && (m_ptr->cdis < MAX_SIGHT + ABS(r_ptr->light)))
     {
-        p_ptr->update |= (PU_UPDATE_VIEW);
+        p_ptr->update |= (PU_UPDATE_LIGHT);
     }
 
     // shuffle along the array of previous actions
@@ -5997,6 +6285,24 @@ void process_monsters(s16b minimum_energy)
     }
 }
 
+/*
+ * Structure-of-arrays buffers for the batched perception stage.
+ *
+ * monster_perception() first gathers the inputs of every monster that can
+ * hear the sound into these arrays, then works out the deterministic part of
+ * each monster's perception in flat loops, and only then makes the random
+ * rolls.  The monsters are visited in the same (backwards) order in both the
+ * gathering and rolling stages, so the RNG sequence is unchanged.
+ */
+static s16b perc_idx[MAX_MONSTERS];
+static s16b perc_skill[MAX_MONSTERS];
+static s16b perc_noise[MAX_MONSTERS];
+static s16b perc_alertness[MAX_MONSTERS];
+static s16b perc_bane[MAX_MONSTERS];
+static byte perc_aggravate[MAX_MONSTERS];
+static byte perc_los[MAX_MONSTERS];
+static s16b perc_total[MAX_MONSTERS];
+
 /*
  * Lets all monsters attempt to notice the player.
  * It can get called multiple times per playerturn.
@@ -6009,10 +6315,10 @@ void process_monsters(s16b minimum_energy)
 
 void monster_perception(bool player_centered, bool main_roll, int difficulty)
 {
-    int i;
+    int i, n;
     int m_perception;
     int result;
-    int noise_dist;
+    int which_flow;
     monster_type* m_ptr;
     monster_race* r_ptr;
     monster_lore* l_ptr;
@@ -6021,6 +6327,10 @@ void monster_perception(bool player_centered, bool main_roll, int difficulty)
 
     int combat_noise_bonus = 0;
     int combat_sight_bonus = 0;
+    int base_bonus;
+    int sight_bonus;
+    int aggravate_bonus;
+    int d, open_squares = 0;
 
     /* Player is dead or leaving the current level */
     if (p_ptr->leaving)
@@ -6071,127 +6381,138 @@ void monster_perception(bool player_centered, bool main_roll, int difficulty)
     if (singing(SNG_SILENCE))
         difficulty_roll += ability_bonus(S_SNG, SNG_SILENCE);
 
-    /* Process the monsters (backwards) */
-    for (i = mon_max - 1; i >= 1; i--)
+    which_flow = player_centered ? FLOW_PLAYER_NOISE : FLOW_MONSTER_NOISE;
+
+    /*
+     * Stage one: gather the inputs of the monsters that can perceive
+     * (backwards, to match the order of the rolls below)
+     */
+    for (n = 0, i = mon_max - 1; i >= 1; i--)
     {
         /* Access the monster */
         m_ptr = &mon_list[i];
 
-        // Access the race and lore information
-        r_ptr = &r_info[m_ptr->r_idx];
-        l_ptr = &l_list[m_ptr->r_idx];
-
         /* Ignore dead monsters */
         if (!m_ptr->r_idx)
             continue;
 
+        // Access the race information
+        r_ptr = &r_info[m_ptr->r_idx];
+
         /* If character is within detection range (unlimited for most monsters,
          * 2 for shortsighted ones) */
-        if (!((r_ptr->flags2 & (RF2_SHORT_SIGHTED)) && (m_ptr->cdis > 2)))
+        if ((r_ptr->flags2 & (RF2_SHORT_SIGHTED)) && (m_ptr->cdis > 2))
+            continue;
+
+        perc_idx[n] = i;
+        perc_skill[n] = monster_skill(m_ptr, S_PER);
+        perc_noise[n] = flow_dist(which_flow, m_ptr->fy, m_ptr->fx);
+        perc_alertness[n] = m_ptr->alertness;
+
+        // deal with bane ability (theoretically should modify player roll,
+        // but this is equivalent) and increase for the Elf-Bane ability
+        perc_bane[n] = elf_bane_bonus(m_ptr) - bane_bonus(m_ptr);
+
+        // aggravation only works on non-sleeping monsters with minds
+        perc_aggravate[n] = !(r_ptr->flags2 & (RF2_MINDLESS));
+
+        // awake creatures who have line of sight on player get a bonus
+        perc_los[n] = (m_ptr->alertness >= ALERTNESS_UNWARY)
+            && los(m_ptr->fy, m_ptr->fx, p_ptr->py, p_ptr->px);
+
+        n++;
+    }
+
+    /* Nobody can hear it */
+    if (n == 0)
+        return;
+
+    // the open squares around the player are the same for every monster
+    for (d = 0; d < 8; d++)
+    {
+        int dir = cycle[d];
+
+        if (cave_floor_bold(p_ptr->py + ddy[dir], p_ptr->px + ddx[dir]))
         {
-            if (player_centered)
-            {
-                noise_dist = flow_dist(FLOW_PLAYER_NOISE, m_ptr->fy, m_ptr->fx);
-            }
-            else
-            {
-                noise_dist
-                    = flow_dist(FLOW_MONSTER_NOISE, m_ptr->fy, m_ptr->fx);
-            }
+            open_squares++;
+        }
+    }
 
-            // start building up the monster's total perception
-            m_perception
-                = monster_skill(m_ptr, S_PER) - noise_dist + combat_noise_bonus;
+    // bonus for seeing the player is reduced if the player has 'disguise'
+    if (p_ptr->active_ability[S_STL][STL_DISGUISE])
+        sight_bonus = (open_squares + combat_sight_bonus) / 2;
+    else
+        sight_bonus = open_squares + combat_sight_bonus;
 
-            // deal with bane ability (theoretically should modify player roll,
-            // but this is equivalent)
-            m_perception -= bane_bonus(m_ptr);
+    // monsters are looking more carefully during the escape
+    base_bonus = combat_noise_bonus + (p_ptr->on_the_run ? 5 : 0);
 
-            // increase morale for the Elf-Bane ability
-            m_perception += elf_bane_bonus(m_ptr);
+    // aggravation makes non-sleeping monsters much more likely to notice you
+    aggravate_bonus = p_ptr->aggravate * 10;
 
-            // monsters are looking more carefully during the escape
-            if (p_ptr->on_the_run)
-                m_perception += 5;
+    /*
+     * Stage two: the deterministic part of each monster's perception
+     */
+    for (i = 0; i < n; i++)
+    {
+        int alert = perc_alertness[i];
 
-            // monsters that are already alert get a penalty to the roll to stop
-            // them getting *too* alert
-            if (m_ptr->alertness >= ALERTNESS_ALERT)
-                m_perception -= m_ptr->alertness;
+        m_perception = perc_skill[i] - perc_noise[i] + base_bonus + perc_bane[i];
 
-            // aggravation makes non-sleeping monsters much more likely to
-            // notice you
-            if (p_ptr->aggravate && (m_ptr->alertness >= ALERTNESS_UNWARY)
-                && !(r_ptr->flags2 & (RF2_MINDLESS)))
-            {
-                m_perception += p_ptr->aggravate * 10;
-            }
+        // monsters that are already alert get a penalty to the roll to stop
+        // them getting *too* alert
+        m_perception -= (alert >= ALERTNESS_ALERT) ? alert : 0;
 
-            // awake creatures who have line of sight on player get a bonus
-            if (los(m_ptr->fy, m_ptr->fx, p_ptr->py, p_ptr->px)
-                && (m_ptr->alertness >= ALERTNESS_UNWARY))
-            {
-                int d, dir, y, x, open_squares = 0;
+        m_perception += (alert >= ALERTNESS_UNWARY) * perc_aggravate[i]
+            * aggravate_bonus;
 
-                // check adjacent squares for impassable squares
-                for (d = 0; d < 8; d++)
-                {
-                    dir = cycle[d];
+        m_perception += perc_los[i] * sight_bonus;
 
-                    y = p_ptr->py + ddy[dir];
-                    x = p_ptr->px + ddx[dir];
+        perc_total[i] = m_perception;
+    }
 
-                    if (cave_floor_bold(y, x))
-                    {
-                        open_squares++;
-                    }
-                }
+    /*
+     * Stage three: the random rolls, in the same order as they were gathered
+     */
+    for (i = 0; i < n; i++)
+    {
+        m_ptr = &mon_list[perc_idx[i]];
+        l_ptr = &l_list[m_ptr->r_idx];
+        m_perception = perc_total[i];
 
-                // bonus reduced if the player has 'disguise'
-                if (p_ptr->active_ability[S_STL][STL_DISGUISE])
-                {
-                    m_perception += (open_squares + combat_sight_bonus) / 2;
-                }
-                else
-                {
-                    m_perception += open_squares + combat_sight_bonus;
-                }
-            }
+        // do the 'skill_check()' versus the quietness of the sound...
+        result = (m_perception + dieroll(10)) - difficulty_roll;
 
-            // do the 'skill_check()' versus the quietness of the sound...
-            result = (m_perception + dieroll(10)) - difficulty_roll;
+        /* Debugging message */
+        if (cheat_skill_rolls)
+        {
+            msg_format("{%d+%d v %d+%d = %d}.",
+                result - m_perception + difficulty_roll, m_perception,
+                difficulty_roll - difficulty, difficulty, result);
+        }
 
-            /* Debugging message */
-            if (cheat_skill_rolls)
-            {
-                msg_format("{%d+%d v %d+%d = %d}.",
-                    result - m_perception + difficulty_roll, m_perception,
-                    difficulty_roll - difficulty, difficulty, result);
-            }
+        if (result > 0)
+        {
+            // Partly alert monster
+            set_alertness(m_ptr, m_ptr->alertness + result);
 
-            if (result > 0)
+            /* Still not alert */
+            if (m_ptr->alertness < ALERTNESS_ALERT)
             {
-                // Partly alert monster
-                set_alertness(m_ptr, m_ptr->alertness + result);
-
-                /* Still not alert */
-                if (m_ptr->alertness < ALERTNESS_ALERT)
+                /* Notice the "not noticing" */
+                if (m_ptr->ml && (l_ptr->ignore < MAX_UCHAR))
                 {
-                    /* Notice the "not noticing" */
-                    if (m_ptr->ml && (l_ptr->ignore < MAX_UCHAR))
-                    {
-                        l_ptr->ignore++;
-                    }
+                    l_ptr->ignore++;
                 }
+            }
 
-                /* Just became alert */
-                else
+            /* Just became alert */
+            else
+            {
+                /* Notice the "noticing" */
+                if (m_ptr->ml && (l_ptr->notice < MAX_UCHAR))
                 {
-                    /* Notice the "noticing" */
-                    if (m_ptr->ml && (l_ptr->notice < MAX_UCHAR))
-                    {
-                        l_ptr->notice++;
-                    }
+                    l_ptr->notice++;
                 }
             }
         }
@@ -139,6 +139,10 @@ void delete_monster_idx(int i)
     /* Hack -- Reduce the racial counter */
     r_ptr->cur_num--;
 
+    /* The race may appear again */
+    if (r_ptr->cur_num + 1 == r_ptr->max_num)
+        alloc_race_stamp++;
+
     /* Hack -- count the number of "reproducers" */
     if (r_ptr->flags2 & (RF2_MULTIPLY))
         num_repro--;
@@ -153,6 +157,7 @@ void delete_monster_idx(int i)
 
     /* Monster is gone */
     cave_m_idx[y][x] = 0;
+    note_player_neighbour(y, x);
 
     /* Delete objects */
     for (this_o_idx = m_ptr->hold_o_idx; this_o_idx; this_o_idx = next_o_idx)
@@ -416,6 +421,10 @@ void wipe_mon_list(void)
         /* Hack -- Reduce the racial counter */
         r_ptr->cur_num--;
 
+        /* The race may appear again */
+        if (r_ptr->cur_num + 1 == r_ptr->max_num)
+            alloc_race_stamp++;
+
         /* Monster is gone */
         cave_m_idx[m_ptr->fy][m_ptr->fx] = 0;
 
@@ -499,6 +508,8 @@ s16b mon_pop(void)
  */
 errr get_mon_num_prep(void)
 {
+    static u32b serial = 1;
+
     int i;
 
     /* Scan the allocation table */
@@ -522,6 +533,9 @@ errr get_mon_num_prep(void)
         }
     }
 
+    /* Candidates picked under any other restriction no longer apply */
+    alloc_race_prep = get_mon_num_hook ? ++serial : 1;
+
     /* Success */
     return (0);
 }
@@ -530,9 +544,9 @@ errr get_mon_num_prep(void)
  * Choose a monster race that seems "appropriate" to the given level
  *
  * This function uses the "prob2" field of the "monster allocation table",
- * and various local information, to calculate the "prob3" field of the
- * same table, which is then used to choose an "appropriate" monster, in
- * a relatively efficient manner.
+ * and various local information, to pick out the "appropriate" monsters,
+ * which are kept (see "alloc_cache_find()") for the next time the same
+ * pick is made, and then chooses one of them with a single draw.
  *
  * There is a small chance (1/50) of "boosting" the given depth by
  * a small amount (up to four levels), and
@@ -567,7 +581,9 @@ s16b get_mon_num(int level, bool special, bool allow_non_smart, bool vault)
 
     int r_idx;
 
-    long value, total;
+    u32b key;
+
+    alloc_cache* c;
 
     monster_race* r_ptr;
 
@@ -653,90 +669,86 @@ s16b get_mon_num(int level, bool special, bool allow_non_smart, bool vault)
             generation_level = MORGOTH_DEPTH + 3;
     }
 
-    /* Reset total */
-    total = 0L;
+    /* Everything the candidates depend on */
+    key = (u32b)generation_level | ((u32b)p_ptr->depth << 8)
+        | (special ? 0x10000L : 0) | (pursuing_monster ? 0x20000L : 0)
+        | (allow_non_smart ? 0x40000L : 0);
 
-    /* Process probabilities */
-    for (i = 0; i < alloc_race_size; i++)
+    /* Find the candidates */
+    c = alloc_cache_find(
+        alloc_race_cache, key, alloc_race_prep, alloc_race_stamp);
+
+    /* Pick them out, if need be */
+    if (c->num < 0)
     {
-        /* Monsters are sorted by depth */
-        if (table[i].level > generation_level)
-            break;
+        c->num = 0;
 
-        /* Default */
-        table[i].prob3 = 0;
+        /* Process probabilities */
+        for (i = 0; i < alloc_race_size; i++)
+        {
+            /* Monsters are sorted by depth */
+            if (table[i].level > generation_level)
+                break;
 
-        /* Get the "r_idx" of the chosen monster */
-        r_idx = table[i].index;
+            /* Get the "r_idx" of the chosen monster */
+            r_idx = table[i].index;
 
-        /* Get the actual race */
-        r_ptr = &r_info[r_idx];
+            /* Get the actual race */
+            r_ptr = &r_info[r_idx];
 
-        /* Unless in 'special' generation, ignore monsters before the
-         * appropriate level */
-        if (!special && (table[i].level < generation_level))
-            continue;
-
-        /* Even in 'special' generation, ignore monsters before 1/2 the
-         * appropriate level */
-        if (special && (table[i].level <= generation_level / 2))
-            continue;
+            /* Unless in 'special' generation, ignore monsters before the
+             * appropriate level */
+            if (!special && (table[i].level < generation_level))
+                continue;
 
-        /* Ignore monsters which are too prolific */
-        if (r_ptr->cur_num >= r_ptr->max_num)
-            continue;
+            /* Even in 'special' generation, ignore monsters before 1/2 the
+             * appropriate level */
+            if (special && (table[i].level <= generation_level / 2))
+                continue;
 
-        /* Forced depth monsters never appear out of depth */
-        if ((r_ptr->flags1 & (RF1_FORCE_DEPTH))
-            && (r_ptr->level > p_ptr->depth))
-        {
-            continue;
-        }
+            /* Ignore monsters which are too prolific */
+            if (r_ptr->cur_num >= r_ptr->max_num)
+                continue;
 
-        /* Non-moving monsters can't appear as out-of-depth pursuing monsters */
-        if ((r_ptr->flags1 & (RF1_NEVER_MOVE)) && pursuing_monster)
-        {
-            continue;
-        }
+            /* Forced depth monsters never appear out of depth */
+            if ((r_ptr->flags1 & (RF1_FORCE_DEPTH))
+                && (r_ptr->level > p_ptr->depth))
+            {
+                continue;
+            }
 
-        /* Territorial monsters can't appear as out-of-depth pursuing monsters
-         */
-        if ((r_ptr->flags2 & (RF2_TERRITORIAL)) && pursuing_monster)
-        {
-            continue;
-        }
+            /* Non-moving monsters can't appear as out-of-depth pursuing
+             * monsters */
+            if ((r_ptr->flags1 & (RF1_NEVER_MOVE)) && pursuing_monster)
+            {
+                continue;
+            }
 
-        // forbid the generation of non-smart monsters except at level-creation
-        // or specific summons
-        if (!allow_non_smart
-            && !((r_ptr->flags2 & (RF2_SMART))
-                && !(r_ptr->flags2 & (RF2_TERRITORIAL))))
-            continue;
+            /* Territorial monsters can't appear as out-of-depth pursuing
+             * monsters */
+            if ((r_ptr->flags2 & (RF2_TERRITORIAL)) && pursuing_monster)
+            {
+                continue;
+            }
 
-        /* Accept */
-        table[i].prob3 = table[i].prob2;
+            // forbid the generation of non-smart monsters except at
+            // level-creation or specific summons
+            if (!allow_non_smart
+                && !((r_ptr->flags2 & (RF2_SMART))
+                    && !(r_ptr->flags2 & (RF2_TERRITORIAL))))
+                continue;
 
-        /* Total */
-        total += table[i].prob3;
+            /* Accept */
+            alloc_cache_add(c, i, table[i].prob2);
+        }
     }
 
-    /* No legal monsters */
-    if (total <= 0)
-        return (0);
-
     /* Pick a monster */
-    value = rand_int(total);
-
-    /* Find the monster */
-    for (i = 0; i < alloc_race_size; i++)
-    {
-        /* Found the entry */
-        if (value < table[i].prob3)
-            break;
+    i = alloc_cache_pick(c);
 
-        /* Decrement */
-        value = value - table[i].prob3;
-    }
+    /* No legal monsters */
+    if (i < 0)
+        return (0);
 
     /* Result */
     return (table[i].index);
@@ -1266,7 +1278,7 @@ int monster_stat(monster_type* m_ptr, int stat_type)
     return (stat);
 }
 
-void listen(monster_type* m_ptr)
+static void listen_to_monster(monster_type* m_ptr)
 {
     byte a;
     char c;
@@ -1666,7 +1678,7 @@ void update_mon(int m_idx, bool full)
         Rand_state[i] = playerturn * i * 15485863; // large prime
     }
 
-    listen(m_ptr);
+    listen_to_monster(m_ptr);
 
     Rand_place = tmp_rand_place;
 
@@ -2145,10 +2157,12 @@ void monster_swap(int y1, int x1, int y2, int x2)
     /* Update grids */
     cave_m_idx[y1][x1] = m2;
     cave_m_idx[y2][x2] = m1;
+    note_player_neighbour(y1, x1);
+    note_player_neighbour(y2, x2);
 
     /* Redraw */
-    lite_spot(y1, x1);
-    lite_spot(y2, x2);
+    queue_spot(y1, x1);
+    queue_spot(y2, x2);
 
     // deal with set polearm attacks
     if (p_ptr->active_ability[S_MEL][MEL_POLEARMS] && monster1 && m_ptr->ml)
@@ -2205,7 +2219,10 @@ s16b player_place(int y, int x)
     /* Mark cave grid */
     cave_m_idx[y][x] = -1;
     if (cave_feat[y][x] == FEAT_RUBBLE)
+    {
         cave_feat[y][x] = FEAT_FLOOR;
+        wipe_flow_cache();
+    }
 
     /* Success */
     return (-1);
@@ -2233,6 +2250,7 @@ s16b monster_place(int y, int x, monster_type* n_ptr)
     {
         /* Make a new monster */
         cave_m_idx[y][x] = m_idx;
+        note_player_neighbour(y, x);
 
         /* Get the new monster */
         m_ptr = &mon_list[m_idx];
@@ -2260,6 +2278,10 @@ s16b monster_place(int y, int x, monster_type* n_ptr)
 
         /* Count racial occurances */
         r_ptr->cur_num++;
+
+        /* The race may not appear again */
+        if (r_ptr->cur_num == r_ptr->max_num)
+            alloc_race_stamp++;
     }
 
     /* Result */
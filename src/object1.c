@@ -228,6 +228,9 @@ void reset_visuals(bool unused)
         f_ptr->x_char = f_ptr->d_char;
     }
 
+    /* The map must be worked out again */
+    wipe_map_memo();
+
     /* Extract default attr/char code for objects */
     for (i = 0; i < z_info->k_max; i++)
     {
@@ -583,6 +583,8 @@ object_type* get_next_object(const object_type* o_ptr)
  */
 void get_obj_num_prep(void)
 {
+    static u32b serial = 1;
+
     int i;
 
     /* Get the entry */
@@ -612,15 +614,18 @@ void get_obj_num_prep(void)
             table[i].prob2 = 0;
         }
     }
+
+    /* Candidates picked under any other restriction no longer apply */
+    alloc_kind_prep = get_obj_num_hook ? ++serial : 1;
 }
 
 /*
  * Choose an object kind that seems "appropriate" to the given level
  *
  * This function uses the "prob2" field of the "object allocation table",
- * and various local information, to calculate the "prob3" field of the
- * same table, which is then used to choose an "appropriate" object, in
- * a relatively efficient manner.
+ * and various local information, to pick out the "appropriate" objects,
+ * which are kept (see "alloc_cache_find()") for the next time the same
+ * pick is made, and then chooses among them with single draws.
  *
  * It is (slightly) more likely to acquire an object of the given level
  * than one of a lower level.  This is done by choosing several objects
@@ -636,7 +641,9 @@ s16b get_obj_num(int level)
 
     int k_idx;
 
-    long value, total;
+    u32b key;
+
+    alloc_cache* c;
 
     object_kind* k_ptr;
 
@@ -666,54 +673,47 @@ s16b get_obj_num(int level)
         }
     }
 
-    /* Reset total */
-    total = 0L;
+    /* Everything the candidates depend on */
+    key = (u32b)level
+        | ((object_generation_mode == OB_GEN_MODE_CHEST) ? 0x10000L : 0);
 
-    /* Process probabilities */
-    for (i = 0; i < alloc_kind_size; i++)
-    {
-        /* Objects are sorted by depth */
-        if (table[i].level > level)
-            break;
+    /* Find the candidates */
+    c = alloc_cache_find(alloc_kind_cache, key, alloc_kind_prep, 0);
 
-        /* Default */
-        table[i].prob3 = 0;
+    /* Pick them out, if need be */
+    if (c->num < 0)
+    {
+        c->num = 0;
 
-        /* Get the index */
-        k_idx = table[i].index;
+        /* Process probabilities */
+        for (i = 0; i < alloc_kind_size; i++)
+        {
+            /* Objects are sorted by depth */
+            if (table[i].level > level)
+                break;
 
-        /* Get the actual kind */
-        k_ptr = &k_info[k_idx];
+            /* Get the index */
+            k_idx = table[i].index;
 
-        /* Hack -- prevent embedded chests*/
-        if ((object_generation_mode == OB_GEN_MODE_CHEST)
-            && (k_ptr->tval == TV_CHEST))
-            continue;
+            /* Get the actual kind */
+            k_ptr = &k_info[k_idx];
 
-        /* Accept */
-        table[i].prob3 = table[i].prob2;
+            /* Hack -- prevent embedded chests*/
+            if ((object_generation_mode == OB_GEN_MODE_CHEST)
+                && (k_ptr->tval == TV_CHEST))
+                continue;
 
-        /* Total */
-        total += table[i].prob3;
+            /* Accept */
+            alloc_cache_add(c, i, table[i].prob2);
+        }
     }
 
-    /* No legal objects */
-    if (total <= 0)
-        return (0);
-
     /* Pick an object */
-    value = rand_int(total);
-
-    /* Find the object */
-    for (i = 0; i < alloc_kind_size; i++)
-    {
-        /* Found the entry */
-        if (value < table[i].prob3)
-            break;
+    i = alloc_cache_pick(c);
 
-        /* Decrement */
-        value = value - table[i].prob3;
-    }
+    /* No legal objects */
+    if (i < 0)
+        return (0);
 
     /* Power boost */
     p = rand_int(100);
@@ -725,18 +725,7 @@ s16b get_obj_num(int level)
         j = i;
 
         /* Pick a object */
-        value = rand_int(total);
-
-        /* Find the monster */
-        for (i = 0; i < alloc_kind_size; i++)
-        {
-            /* Found the entry */
-            if (value < table[i].prob3)
-                break;
-
-            /* Decrement */
-            value = value - table[i].prob3;
-        }
+        i = alloc_cache_pick(c);
 
         /* Keep the "best" one */
         if (table[i].level < table[j].level)
@@ -750,18 +739,7 @@ s16b get_obj_num(int level)
         j = i;
 
         /* Pick a object */
-        value = rand_int(total);
-
-        /* Find the object */
-        for (i = 0; i < alloc_kind_size; i++)
-        {
-            /* Found the entry */
-            if (value < table[i].prob3)
-                break;
-
-            /* Decrement */
-            value = value - table[i].prob3;
-        }
+        i = alloc_cache_pick(c);
 
         /* Keep the "best" one */
         if (table[i].level < table[j].level)
@@ -3761,7 +3739,7 @@ s16b floor_carry(int y, int x, object_type* j_ptr)
         note_spot(y, x);
 
         /* Redraw */
-        lite_spot(y, x);
+        queue_spot(y, x);
     }
 
     /* Result */
@@ -868,15 +868,15 @@ static void wr_extra(void)
     wr_byte(p_ptr->self_made_arts);
 
     wr_byte(p_ptr->climbing);
+    wr_u32b(p_ptr->levels_generated);
 
-    // 19 spare bytes
+    // 15 spare bytes
     wr_byte(0);
     wr_byte(0);
     wr_byte(0);
     wr_u32b(0L);
     wr_u32b(0L);
     wr_u32b(0L);
-    wr_u32b(0L);
 
     /* Save item-quality squelch sub-menu */
     for (i = 0; i < SQUELCH_BYTES; i++)
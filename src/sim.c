@@ -0,0 +1,596 @@
+/* File: sim.c */
+
+/*
+ * This software may be copied and distributed for educational, research,
+ * and not for profit purposes provided that this copyright and statement
+ * are included in all such copies.  Other copyrights may also apply.
+ */
+
+#include "angband.h"
+
+/*
+ * Headless Monte-Carlo combat simulator.
+ *
+ * Pits the current character against fresh copies of monster races, over
+ * and over, using the real combat formulas ("hit_roll()",
+ * "total_player_attack()", "crit_bonus()", "slay_bonus()",
+ * "protection_roll()" and friends) but without any of the messages, screen
+ * updates, lore or knowledge changes that go with a real fight.
+ *
+ * Each fight is a straight duel: the monster starts adjacent to the
+ * character (or at a distance, for archery), both sides gain energy at their
+ * normal rate, and they trade blows until one of them is dead or the fight
+ * runs out of time.  Monster spells, ranged attacks, morale, abilities that
+ * need a real map (charges, knock back, etc.) and the like are not modelled.
+ *
+ * The player, the race's lore and the RNG are all restored afterwards, so a
+ * simulation has no effect on the game in progress.  The RNG is seeded for
+ * each race, so a given character, race and seed always gives the same
+ * report.  The report also gives the time taken, which makes it a handy
+ * benchmark of the combat code.
+ *
+ * It can be run from the debug commands, or with no display at all with
+ * "-b" (see "sim_run()"), for batch balance checks and benchmarks.
+ */
+
+/*
+ * Give up on fights that last longer than this many game turns
+ */
+#define SIM_MAX_GAME_TURNS 10000
+
+/*
+ * Number of buckets for the histograms of damage and kill times
+ */
+#define SIM_HIST_MAX 10
+
+/*
+ * Width of each bucket of the kill time histogram (in player turns)
+ */
+#define SIM_TURN_BUCKET 2
+
+/*
+ * Statistics for one race
+ */
+typedef struct sim_stats sim_stats;
+
+struct sim_stats
+{
+    long fights;
+    long wins;
+    long losses;
+    long draws;
+
+    long p_attacks;
+    long p_hits;
+    long p_damage;
+    long p_hist[SIM_HIST_MAX];
+
+    long m_attacks;
+    long m_hits;
+    long m_damage;
+    long m_hist[SIM_HIST_MAX];
+
+    long kill_turns;
+    long kill_hist[SIM_HIST_MAX];
+};
+
+/*
+ * Put a value into a histogram bucket
+ */
+static void sim_hist_add(long* hist, int value, int width)
+{
+    int bucket = value / width;
+
+    if (bucket >= SIM_HIST_MAX)
+        bucket = SIM_HIST_MAX - 1;
+    if (bucket < 0)
+        bucket = 0;
+
+    hist[bucket]++;
+}
+
+/*
+ * Width of each damage bucket for a race (roughly a tenth of its health)
+ */
+static int sim_damage_width(const monster_race* r_ptr)
+{
+    int width = (r_ptr->hdice * (1 + r_ptr->hside) / 2) / SIM_HIST_MAX;
+
+    return (MAX(width, 1));
+}
+
+/*
+ * The character makes one melee attack (with all blows) on the monster.
+ *
+ * This follows the core of "py_attack_aux()".
+ */
+static void sim_player_melee(monster_type* m_ptr, sim_stats* s)
+{
+    monster_race* r_ptr = &r_info[m_ptr->r_idx];
+    object_type* o_ptr = &inventory[INVEN_WIELD];
+
+    int num = 0;
+    int blows = 1;
+    int attack_mod = p_ptr->skill_use[S_MEL];
+    int weapon_weight = o_ptr->weight ? o_ptr->weight : 40;
+    int mdd = p_ptr->mdd;
+    int mds = p_ptr->mds;
+    int width = sim_damage_width(r_ptr);
+
+    u32b f1, f2, f3;
+    u32b noticed_flag = 0;
+
+    object_flags(o_ptr, &f1, &f2, &f3);
+
+    if (p_ptr->active_ability[S_MEL][MEL_RAPID_ATTACK])
+        blows++;
+    if (p_ptr->mds2 > 0)
+        blows++;
+
+    while ((num++ < blows) && (m_ptr->hp > 0))
+    {
+        int total_attack_mod, total_evasion_mod;
+        int hit_result;
+
+        // adjust for off-hand weapon if it is being used
+        if ((num == blows) && (num != 1) && (p_ptr->mds2 > 0))
+        {
+            attack_mod += p_ptr->offhand_mel_mod;
+            mdd = p_ptr->mdd2;
+            mds = p_ptr->mds2;
+            o_ptr = &inventory[INVEN_ARM];
+            weapon_weight = o_ptr->weight;
+            object_flags(o_ptr, &f1, &f2, &f3);
+        }
+
+        total_attack_mod = total_player_attack(
+            m_ptr, attack_mod + stealth_melee_bonus(m_ptr));
+        total_evasion_mod = total_monster_evasion(m_ptr, false);
+
+        hit_result = hit_roll(
+            total_attack_mod, total_evasion_mod, PLAYER, m_ptr, false);
+
+        if ((hit_result <= 0) && (f3 & TR3_ACCURATE))
+        {
+            hit_result = hit_roll(
+                total_attack_mod, total_evasion_mod, PLAYER, m_ptr, false);
+        }
+
+        s->p_attacks++;
+
+        if (hit_result > 0)
+        {
+            int crit_bonus_dice, slay_bonus_dice;
+            int dam, prt, net_dam;
+
+            crit_bonus_dice = crit_bonus(
+                hit_result, weapon_weight, r_ptr, S_MEL, false, NULL);
+            slay_bonus_dice = slay_bonus(o_ptr, m_ptr, &noticed_flag);
+
+            if (f3 & TR3_CUMBERSOME)
+                crit_bonus_dice = 0;
+
+            dam = damroll(mdd + slay_bonus_dice + crit_bonus_dice, mds);
+
+            prt = damroll((r_ptr->pd + curse_flag_count(CUR_MON_ARM_DICE)),
+                (r_ptr->ps + curse_flag_count(CUR_MON_ARM_SIDE)));
+            prt = (prt * MAX(prt_after_sharpness(o_ptr, &noticed_flag), 0))
+                / 100;
+
+            net_dam = MAX(dam - prt, 0);
+
+            s->p_hits++;
+            s->p_damage += net_dam;
+            sim_hist_add(s->p_hist, net_dam, width);
+
+            m_ptr->hp -= net_dam;
+        }
+    }
+}
+
+/*
+ * The character fires one arrow at the monster.
+ *
+ * This follows the core of "do_cmd_fire()".
+ */
+static void sim_player_fire(monster_type* m_ptr, sim_stats* s)
+{
+    monster_race* r_ptr = &r_info[m_ptr->r_idx];
+    object_type* j_ptr = &inventory[INVEN_BOW];
+    object_type* i_ptr = &inventory[INVEN_QUIVER1];
+
+    int total_attack_mod, total_evasion_mod;
+    int hit_result;
+    int width = sim_damage_width(r_ptr);
+
+    u32b f1, f2, f3;
+    u32b noticed_flag = 0;
+
+    object_flags(j_ptr, &f1, &f2, &f3);
+
+    total_attack_mod
+        = total_player_attack(m_ptr, p_ptr->skill_use[S_ARC] + i_ptr->att);
+    total_evasion_mod = total_monster_evasion(m_ptr, true);
+
+    hit_result
+        = hit_roll(total_attack_mod, total_evasion_mod, PLAYER, m_ptr, false);
+
+    if ((hit_result <= 0) && (f3 & TR3_ACCURATE))
+    {
+        hit_result = hit_roll(
+            total_attack_mod, total_evasion_mod, PLAYER, m_ptr, false);
+    }
+
+    s->p_attacks++;
+
+    if (hit_result > 0)
+    {
+        int prt_percent = prt_after_sharpness(i_ptr, &noticed_flag);
+        int crit_bonus_dice, slay_bonus_dice;
+        int dam, prt, net_dam;
+
+        crit_bonus_dice
+            = crit_bonus(hit_result, j_ptr->weight, r_ptr, S_ARC, false, NULL);
+
+        if (f3 & TR3_CUMBERSOME)
+            crit_bonus_dice = 0;
+
+        slay_bonus_dice = slay_bonus(i_ptr, m_ptr, &noticed_flag);
+        slay_bonus_dice += slay_bonus(j_ptr, m_ptr, &noticed_flag);
+
+        dam = damroll(j_ptr->dd + crit_bonus_dice + slay_bonus_dice,
+            MAX(total_ads(j_ptr), 0));
+        prt = (damroll(r_ptr->pd, r_ptr->ps) * prt_percent) / 100;
+
+        net_dam = MAX(dam - prt, 0);
+
+        s->p_hits++;
+        s->p_damage += net_dam;
+        sim_hist_add(s->p_hist, net_dam, width);
+
+        m_ptr->hp -= net_dam;
+    }
+}
+
+/*
+ * The monster makes one melee attack on the character.
+ *
+ * This follows the core of "make_attack_normal()".  Returns the damage done.
+ */
+static int sim_monster_melee(monster_type* m_ptr, sim_stats* s)
+{
+    monster_race* r_ptr = &r_info[m_ptr->r_idx];
+
+    int b, blows;
+    int effect, method, att, dd, ds;
+    int total_attack_mod, total_evasion_mod;
+    int hit_result;
+
+    /* Count the blows */
+    for (blows = 0; blows < MONSTER_BLOW_MAX; blows++)
+    {
+        if (!r_ptr->blow[blows].method)
+            break;
+    }
+
+    // use the alternate attack one in three times
+    b = ((blows > 1) && one_in_(3)) ? 1 : 0;
+
+    effect = r_ptr->blow[b].effect;
+    method = r_ptr->blow[b].method;
+    att = r_ptr->blow[b].att;
+    dd = r_ptr->blow[b].dd;
+    ds = r_ptr->blow[b].ds;
+
+    total_attack_mod = total_monster_attack(m_ptr, att);
+    total_evasion_mod = total_player_evasion(m_ptr, false);
+
+    // spores always hit (and never critical)
+    if (method == RBM_SPORE)
+        hit_result = 1;
+    else
+        hit_result = hit_roll(
+            total_attack_mod, total_evasion_mod, m_ptr, PLAYER, false);
+
+    s->m_attacks++;
+
+    if (!effect || (hit_result > 0))
+    {
+        bool ignores_armour = (method == RBM_TOUCH) || (method == RBM_SPORE);
+        int crit_bonus_dice = 0;
+        int dam, prt, net_dam;
+
+        if (!ignores_armour)
+        {
+            crit_bonus_dice = crit_bonus(
+                hit_result, 20 * dd, &r_info[0], S_MEL, false, m_ptr);
+        }
+
+        dam = damroll(dd + crit_bonus_dice + elem_bonus(effect), ds);
+        prt = ignores_armour ? 0 : protection_roll(GF_HURT, true);
+
+        net_dam = MAX(dam - prt, 0);
+
+        s->m_hits++;
+        s->m_damage += net_dam;
+        sim_hist_add(s->m_hist, net_dam, MAX(p_ptr->mhp / SIM_HIST_MAX, 1));
+
+        return (net_dam);
+    }
+
+    return (0);
+}
+
+/*
+ * Fight a single duel against a fresh monster of the given race
+ */
+static void sim_one_fight(int r_idx, bool archery, sim_stats* s)
+{
+    monster_race* r_ptr = &r_info[r_idx];
+    monster_type monster_type_body;
+    monster_type* m_ptr = &monster_type_body;
+
+    int chp = p_ptr->mhp;
+    int p_energy = 0;
+    int player_turns = 0;
+    int range = archery ? MIN(archery_range(&inventory[INVEN_BOW]), 10) : 1;
+    int game_turn;
+
+    /* Make a fresh, alert monster next to (or in front of) the character */
+    WIPE(m_ptr, monster_type);
+    m_ptr->r_idx = r_idx;
+    m_ptr->fy = p_ptr->py;
+    m_ptr->fx = p_ptr->px + range;
+    m_ptr->ml = true;
+    m_ptr->alertness = ALERTNESS_ALERT;
+    m_ptr->mspeed = MAX(r_ptr->speed, 1);
+    m_ptr->cdis = range;
+
+    if (r_ptr->flags1 & (RF1_UNIQUE))
+        m_ptr->maxhp = r_ptr->hdice * (1 + r_ptr->hside) / 2;
+    else
+        m_ptr->maxhp = damroll(r_ptr->hdice, r_ptr->hside);
+    m_ptr->hp = m_ptr->maxhp;
+
+    s->fights++;
+
+    for (game_turn = 0; game_turn < SIM_MAX_GAME_TURNS; game_turn++)
+    {
+        /* The monster acts */
+        m_ptr->energy += extract_energy[MIN(m_ptr->mspeed, 7)];
+        if (m_ptr->energy >= 100)
+        {
+            m_ptr->energy -= 100;
+
+            /* Close in */
+            if (m_ptr->cdis > 1)
+            {
+                m_ptr->cdis--;
+                m_ptr->fx--;
+            }
+
+            /* Attack */
+            else if (!(r_ptr->flags1 & (RF1_NEVER_BLOW)))
+            {
+                chp -= sim_monster_melee(m_ptr, s);
+
+                if (chp <= 0)
+                {
+                    s->losses++;
+                    return;
+                }
+            }
+        }
+
+        /* The character acts */
+        p_energy += extract_energy[MIN(p_ptr->pspeed, 7)];
+        if (p_energy >= 100)
+        {
+            p_energy -= 100;
+            player_turns++;
+
+            if (archery && (m_ptr->cdis > 1))
+                sim_player_fire(m_ptr, s);
+            else
+                sim_player_melee(m_ptr, s);
+
+            if (m_ptr->hp <= 0)
+            {
+                s->wins++;
+                s->kill_turns += player_turns;
+                sim_hist_add(s->kill_hist, player_turns - 1, SIM_TURN_BUCKET);
+                return;
+            }
+        }
+    }
+
+    /* Ran out of time */
+    s->draws++;
+}
+
+/*
+ * Print the percentage a/b
+ */
+static void sim_percent(FILE* fff, long a, long b)
+{
+    if (b > 0)
+        fprintf(fff, " %5.1f%%", (100.0 * a) / b);
+    else
+        fprintf(fff, "    n/a");
+}
+
+/*
+ * Print a histogram as a row of percentages
+ */
+static void sim_print_hist(FILE* fff, cptr label, const long* hist, int width)
+{
+    int i;
+    long total = 0;
+
+    for (i = 0; i < SIM_HIST_MAX; i++)
+        total += hist[i];
+
+    if (total == 0)
+        return;
+
+    fprintf(fff, "    %-12s (per %d):", label, width);
+    for (i = 0; i < SIM_HIST_MAX; i++)
+    {
+        fprintf(fff, " %3ld", (hist[i] * 100 + total / 2) / total);
+    }
+    fprintf(fff, "\n");
+}
+
+/*
+ * Simulate many fights against each race from r_min to r_max (inclusive) and
+ * write a report to the file.
+ *
+ * Returns the total number of fights.
+ */
+long sim_combat(FILE* fff, int r_min, int r_max, int fights, bool archery,
+    u32b seed)
+{
+    int r_idx, i;
+    long total = 0;
+    clock_t start = clock();
+    double secs;
+
+    player_type player_type_body;
+
+    u32b old_value = Rand_value;
+    u16b old_place = Rand_place;
+    u32b old_state[RAND_DEG];
+    bool old_quick = Rand_quick;
+
+    /* Archery needs a bow and arrows */
+    if (archery
+        && (!inventory[INVEN_BOW].k_idx || !inventory[INVEN_QUIVER1].k_idx))
+    {
+        archery = false;
+    }
+
+    /* Save the things the formulas might change */
+    COPY(&player_type_body, p_ptr, player_type);
+    C_COPY(old_state, Rand_state, RAND_DEG, u32b);
+
+    fprintf(fff, "Combat simulation: %s (%s), %d fights per race, seed %lu\n",
+        op_ptr->full_name, archery ? "archery" : "melee", fights,
+        (unsigned long)seed);
+    fprintf(fff, "Histograms give the percentage of results in each bucket.\n\n");
+    fprintf(fff, "%-30s %5s %7s %7s %7s %7s %7s %7s %7s\n", "Race", "Lev",
+        "Win", "Loss", "Hit", "Dam", "M.Hit", "M.Dam", "Turns");
+
+    for (r_idx = MAX(r_min, 1); (r_idx <= r_max) && (r_idx < z_info->r_max);
+         r_idx++)
+    {
+        monster_race* r_ptr = &r_info[r_idx];
+        monster_lore lore_body;
+        sim_stats s;
+
+        /* Skip empty entries */
+        if (!r_ptr->name)
+            continue;
+
+        WIPE(&s, sim_stats);
+        COPY(&lore_body, &l_list[r_idx], monster_lore);
+
+        /* Each race gets the same dice, whatever was simulated before it */
+        Rand_quick = false;
+        Rand_place = 0;
+        Rand_state_init(seed);
+
+        for (i = 0; i < fights; i++)
+        {
+            sim_one_fight(r_idx, archery, &s);
+        }
+
+        /* Undo any changes to the lore and the character */
+        COPY(&l_list[r_idx], &lore_body, monster_lore);
+        COPY(p_ptr, &player_type_body, player_type);
+
+        total += s.fights;
+
+        fprintf(fff, "%-30.30s %5d", r_name + r_ptr->name, r_ptr->level);
+        sim_percent(fff, s.wins, s.fights);
+        sim_percent(fff, s.losses, s.fights);
+        sim_percent(fff, s.p_hits, s.p_attacks);
+        fprintf(fff, " %7.1f",
+            s.p_hits ? (double)s.p_damage / s.p_hits : 0.0);
+        sim_percent(fff, s.m_hits, s.m_attacks);
+        fprintf(fff, " %7.1f",
+            s.m_hits ? (double)s.m_damage / s.m_hits : 0.0);
+        fprintf(fff, " %7.1f\n",
+            s.wins ? (double)s.kill_turns / s.wins : 0.0);
+
+        sim_print_hist(fff, "damage", s.p_hist, sim_damage_width(r_ptr));
+        sim_print_hist(fff, "damage taken", s.m_hist,
+            MAX(p_ptr->mhp / SIM_HIST_MAX, 1));
+        sim_print_hist(fff, "kill turns", s.kill_hist, SIM_TURN_BUCKET);
+    }
+
+    /* Restore the RNG */
+    Rand_value = old_value;
+    Rand_place = old_place;
+    Rand_quick = old_quick;
+    C_COPY(Rand_state, old_state, RAND_DEG, u32b);
+
+    secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    fprintf(fff, "\n%ld fights in %.2f seconds", total, secs);
+    if (secs > 0)
+        fprintf(fff, " (%.0f fights per second)", total / secs);
+    fprintf(fff, "\n");
+
+    return (total);
+}
+
+/*
+ * Run the simulator with no display, as asked for by "spec", which is of
+ * the form "<from>-<to>:<fights>[:<seed>[:a]]", for the character in the
+ * savefile (see "-u"), and quit.  A race range of "0-0" means every race,
+ * a trailing "a" asks for archery, and the seed defaults to that of the
+ * savefile, as in the debug command.  The report goes to "combat-sim.txt"
+ * in the user directory.
+ */
+void sim_run(cptr spec)
+{
+    int r_min, r_max, fights;
+    unsigned long seed = 0;
+    char mode = 'm';
+    long total;
+
+    char buf[1024];
+    FILE* fff;
+
+    if (sscanf(spec, "%d-%d:%d:%lu:%c", &r_min, &r_max, &fights, &seed, &mode)
+        < 3)
+        quit_fmt("Bad combat simulation '%s'", spec);
+
+    if ((r_min < 0) || (r_max < r_min) || (fights <= 0))
+        quit_fmt("Bad combat simulation '%s'", spec);
+
+    if (!r_max)
+        r_max = z_info->r_max - 1;
+
+    /* The character to fight with */
+    if (!load_player() || !character_loaded)
+        quit_fmt("Cannot load a living character from '%s'", savefile);
+
+    p_ptr->update |= (PU_BONUS | PU_HP | PU_MANA);
+    update_stuff();
+
+    if (!seed)
+        seed = seed_randart;
+
+    path_build(buf, sizeof(buf), ANGBAND_DIR_USER, "combat-sim.txt");
+    fff = my_fopen(buf, "w");
+    if (!fff)
+        quit_fmt("Cannot write '%s'", buf);
+
+    total = sim_combat(fff, r_min, r_max, fights, (mode == 'a'), (u32b)seed);
+
+    if (ferror(fff) || my_fclose(fff))
+        quit_fmt("Cannot write '%s'", buf);
+
+    printf("%ld fights (seed %lu), see %s\n", total, seed, buf);
+}
@@ -4613,6 +4613,9 @@ void sing_song_of_freedom(int score)
         }
     }
 
+    // doors may have been unlocked behind the back of cave_set_feat()
+    wipe_flow_cache();
+
     // then, if any chasms were marked to be closed, do the closing
     if (closed_chasm)
     {
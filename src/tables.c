@@ -980,6 +980,12 @@ const byte option_page[OPT_PAGE_MAX][OPT_PAGE_PER] = {
         OPT_NONE, OPT_NONE, OPT_NONE }
 };
 
+/*
+ * Reasons for throwing away a level (see "GEN_FAIL_XXX")
+ */
+cptr gen_fail_names[GEN_FAIL_MAX] = { "forge", "rooms", "pieces", "stairs",
+    "streamer", "player", "access", "objects", "monsters" };
+
 cptr inscrip_text[MAX_INSCRIP] = { NULL,
     "artefact, cursed", // old: terrible
     "special, cursed", // old: worthless
@@ -57,6 +57,11 @@ typedef byte byte_wid[MAX_DUNGEON_WID];
  */
 typedef s16b s16b_wid[MAX_DUNGEON_WID];
 
+/*
+ * A MAX_DUNGEON_HGT by MAX_DUNGEON_WID array of byte's
+ */
+typedef byte byte_map[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+
 /**** Available Structs ****/
 
 typedef struct maxima maxima;
@@ -72,6 +77,10 @@ typedef struct vault_type vault_type;
 typedef struct object_type object_type;
 typedef struct monster_type monster_type;
 typedef struct alloc_entry alloc_entry;
+typedef struct alloc_cache alloc_cache;
+typedef struct vault_index vault_index;
+typedef struct vault_op vault_op;
+typedef struct vault_layout vault_layout;
 typedef struct owner_type owner_type;
 typedef struct store_type store_type;
 typedef struct player_race player_race;
@@ -639,6 +648,52 @@ struct alloc_entry
     u16b total; /* Unused for now */
 };
 
+/*
+ * The candidates picked out of an allocation table for one kind of pick,
+ * with the running total of their weights (see "alloc_cache_find()")
+ */
+struct alloc_cache
+{
+    u32b key; /* What they were picked for */
+    u32b prep; /* The restriction they were picked under */
+    u32b stamp; /* The state of the table they were picked from */
+    u32b used; /* When they were last used */
+    s16b num; /* Number of candidates (-1 if none picked yet) */
+    s16b* table; /* Their entries in the allocation table */
+    u32b* total; /* Running total of their weights */
+};
+
+/*
+ * One table of the vault index, a run of "alloc_vault_table"
+ */
+struct vault_index
+{
+    u32b start; /* First candidate */
+    u16b num; /* Number of candidates */
+};
+
+/*
+ * One grid of a vault's layout (see "build_vault()")
+ */
+struct vault_op
+{
+    byte dy; /* Row in the layout */
+    byte dx; /* Column in the layout */
+    char c; /* What goes there */
+};
+
+/*
+ * A vault's layout, as a run of "vault_ops" -- every grid that isn't blank,
+ * then again just the grids with a monster or object to place
+ */
+struct vault_layout
+{
+    u32b start; /* First grid */
+    u16b num; /* Number of grids */
+    u16b place; /* Number of grids with something to place */
+    byte max_depth; /* Deepest level it can be built on */
+};
+
 /*
  * A store owner
  */
@@ -924,6 +979,7 @@ struct player_type
     s16b food; /* Current nutrition */
 
     u16b stairs_taken; /* The number of times stairs have been used */
+    u32b levels_generated; /* The number of levels generated so far */
     u16b
         staircasiness; /* Gets higher when stairs are taken and slowly decays */
 
@@ -1180,6 +1236,79 @@ struct high_score
 
 
 
+typedef struct level_type level_type;
+
+/*
+ * A dungeon level -- the planes and lists holding its grids, objects and
+ * monsters, and its counters.
+ *
+ * The globals ("cave_info", "o_list" and so on) point at the planes and
+ * lists of the current level (see "level_set()"), and its counters and
+ * display styles are kept in the globals while it is current.  Anything
+ * worked out from the grids (the view, flows, safety maps, lights, the map
+ * memory and overview) is rebuilt after a switch, and the generator's own
+ * working data only lasts while a level is being built.
+ */
+struct level_type
+{
+    u16b (*info)[256]; /* See "cave_info" and friends */
+    byte (*feat)[MAX_DUNGEON_WID];
+    byte (*color)[MAX_DUNGEON_WID];
+    s16b (*light)[MAX_DUNGEON_WID];
+    s16b (*o_idx)[MAX_DUNGEON_WID];
+    s16b (*m_idx)[MAX_DUNGEON_WID];
+    byte (*when)[MAX_DUNGEON_WID];
+    byte_map* cost;
+
+    object_type* o_list;
+    monster_type* mon_list;
+
+    s16b o_max;
+    s16b o_cnt;
+    s16b mon_max;
+    s16b mon_cnt;
+    s16b num_repro;
+
+    byte feeling;
+    s16b rating;
+    bool good_item_flag;
+    byte num_trap_on_level;
+    char g_vault_name[80];
+    byte do_feeling;
+
+    int style; /* Primary styles (see "styles_init_for_level()") */
+    int vault_style;
+    byte floor_choice[64]; /* Variant of each style */
+    byte door_choice[64];
+    byte vault_floor_choice[64];
+    byte vault_door_choice[64];
+
+    int scent_when;
+    byte flow_center_y[MAX_FLOWS];
+    byte flow_center_x[MAX_FLOWS];
+    byte update_center_y[MAX_FLOWS];
+    byte update_center_x[MAX_FLOWS];
+    s16b wandering_pause[MAX_FLOWS];
+};
+
+typedef struct gen_record gen_record;
+
+/*
+ * What it takes to generate a level again (see "generate_cave()")
+ *
+ * Everything else the generator uses comes from the character: the
+ * artefacts, uniques, greater vaults and unique forge already met are not
+ * placed again, so a key only gives the same level while those are as they
+ * were when it was first built.
+ */
+struct gen_record
+{
+    u32b seed; /* Seed of the level's random stream */
+    s16b depth; /* Depth of the level */
+    u16b stairs_taken; /* Staircases taken before reaching it */
+    byte create_stair; /* Stairs the player arrived by (if any) */
+};
+
 typedef struct combat_roll combat_roll;
 
 struct combat_roll
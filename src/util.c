@@ -1643,6 +1643,81 @@ errr macro_trigger_free(void)
     return (0);
 }
 
+/*
+ * Time of the last screen refresh made by "fresh_limited()", and whether
+ * a refresh has been skipped since then.
+ */
+static u32b fresh_last = 0;
+static bool fresh_pending = false;
+
+/*
+ * Return a millisecond clock, for pacing and timestamping screen refreshes
+ */
+u32b clock_msec(void)
+{
+#ifdef SET_UID
+
+    struct timeval tv;
+
+    (void)gettimeofday(&tv, NULL);
+
+    return ((u32b)tv.tv_sec * 1000L + (u32b)(tv.tv_usec / 1000));
+
+#else /* SET_UID */
+
+    return ((u32b)((double)clock() * 1000.0 / CLOCKS_PER_SEC));
+
+#endif /* SET_UID */
+}
+
+/*
+ * Refresh the screen, but no more than "fresh_rate" times a second.
+ *
+ * While running, resting or repeating a command the game would otherwise
+ * flush the screen after every player turn, far more often than anyone can
+ * see, which is slow on remote terminals.  Skipped refreshes are remembered
+ * and made good by "fresh_if_pending()" or the next refresh that gets through.
+ */
+void fresh_limited(void)
+{
+    u32b now;
+
+    /* No limit */
+    if (fresh_rate <= 0)
+    {
+        Term_fresh();
+        return;
+    }
+
+    now = clock_msec();
+
+    /* Too soon -- coalesce with a later refresh */
+    if ((now >= fresh_last) && (now - fresh_last < 1000L / fresh_rate))
+    {
+        fresh_pending = true;
+        return;
+    }
+
+    Term_fresh();
+
+    fresh_last = now;
+    fresh_pending = false;
+}
+
+/*
+ * Make any refresh that "fresh_limited()" has been holding back
+ */
+void fresh_if_pending(void)
+{
+    if (!fresh_pending)
+        return;
+
+    Term_fresh();
+
+    fresh_last = clock_msec();
+    fresh_pending = false;
+}
+
 /*
  * Flush all pending input.
  *
@@ -1955,6 +2030,19 @@ char inkey(void)
     /* Hack -- Activate main screen */
     Term_activate(term_screen);
 
+    /* Show any map grids that changed since the last redraw */
+    if (p_ptr->redraw & (PR_SPOTS))
+        prt_spots();
+
+    /* Catch up on subwindows held back by "window_stuff_limited()" */
+    if (p_ptr->window && character_dungeon)
+    {
+        if (inkey_scan)
+            window_stuff_limited();
+        else
+            window_stuff();
+    }
+
     /* (banner redraw countdown moved to per-turn logic in dungeon.c) */
 
     /* Get a key */
@@ -1972,8 +2060,14 @@ char inkey(void)
             /* Hack -- activate proper term */
             Term_activate(old);
 
-            /* Flush output */
-            Term_fresh();
+            /* Flush output (at a limited rate if only scanning) */
+            if (inkey_scan)
+                fresh_limited();
+            else
+            {
+                Term_fresh();
+                fresh_pending = false;
+            }
 
             /* Hack -- activate main screen */
             Term_activate(term_screen);
@@ -4287,6 +4381,101 @@ int damroll(int num, int sides)
     return (sum);
 }
 
+/*
+ * Find the candidates picked out of an allocation table for "key", under
+ * restriction "prep" and with the table in state "stamp", among the
+ * ALLOC_CACHE_MAX sets in "cache".
+ *
+ * If they haven't been picked, the least recently used set is handed back
+ * instead, marked with a "num" of -1, for the caller to empty and refill
+ * with "alloc_cache_add()".
+ */
+alloc_cache* alloc_cache_find(
+    alloc_cache* cache, u32b key, u32b prep, u32b stamp)
+{
+    static u32b clock = 0;
+
+    alloc_cache* old = &cache[0];
+    int i;
+
+    clock++;
+
+    for (i = 0; i < ALLOC_CACHE_MAX; i++)
+    {
+        alloc_cache* c = &cache[i];
+
+        /* Found them */
+        if ((c->num >= 0) && (c->key == key) && (c->prep == prep)
+            && (c->stamp == stamp))
+        {
+            c->used = clock;
+            return (c);
+        }
+
+        /* Track the least recently used */
+        if (c->used < old->used)
+            old = c;
+    }
+
+    /* Reuse it */
+    old->key = key;
+    old->prep = prep;
+    old->stamp = stamp;
+    old->used = clock;
+    old->num = -1;
+
+    return (old);
+}
+
+/*
+ * Add entry "i" of the allocation table to a set of candidates
+ */
+void alloc_cache_add(alloc_cache* c, int i, int weight)
+{
+    /* Never picked */
+    if (weight <= 0)
+        return;
+
+    c->table[c->num] = i;
+    c->total[c->num] = (c->num ? c->total[c->num - 1] : 0) + weight;
+    c->num++;
+}
+
+/*
+ * Pick one of a set of candidates by weight, returning its entry in the
+ * allocation table, or -1 if there are none.
+ *
+ * This is a single draw from the total weight, just as walking the whole
+ * table would be, so the same entry is picked.
+ */
+int alloc_cache_pick(const alloc_cache* c)
+{
+    u32b r;
+    int lo, hi;
+
+    /* Nothing suitable */
+    if (c->num <= 0)
+        return (-1);
+
+    /* Pick a point in the total weight */
+    r = Rand_div(c->total[c->num - 1]);
+
+    /* Find the candidate it falls to */
+    lo = 0;
+    hi = c->num - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+
+        if (c->total[mid] > r)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return (c->table[lo]);
+}
+
 /*
  * Check a char for "vowel-hood"
  */
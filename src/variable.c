@@ -105,6 +105,8 @@ bool inkey_scan; /* See the "inkey()" function */
 bool inkey_flag; /* See the "inkey()" function */
 bool hide_cursor; /* See the "inkey()" function */
 
+s16b fresh_rate = 30; /* Maximum screen refreshes per second (0 for no limit) */
+
 byte object_generation_mode; /* Hack -- use different depth check, prevent
                                 embedded chests */
 
@@ -292,6 +294,12 @@ u16b* temp_g;
 byte* temp_y;
 byte* temp_x;
 
+/*
+ * The current dungeon level, whose planes the "cave_xxx" arrays below
+ * (and "o_list" and "mon_list") point to
+ */
+level_type* cave_level;
+
 /*
  * Array[DUNGEON_HGT][256] of cave grid info flags (padded)
  *
@@ -350,7 +358,23 @@ u32b mon_power_ave[MAX_DEPTH][CREATURE_TYPE_MAX];
 /*
  * Arrays[NUM_FLOWS][DUNGEON_HGT][DUNGEON_WID] of cave grid flow "cost" values
  */
-byte cave_cost[MAX_FLOWS][MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+byte_map* cave_cost;
+
+/*
+ * Array[DUNGEON_HGT][DUNGEON_WID] of distances to the nearest hiding place
+ * out of the player's sight (shared by all fleeing monsters)
+ */
+byte cave_safety[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+
+/*
+ * The same, for monsters which can also escape by the stairs
+ */
+byte cave_safety_stair[MAX_DUNGEON_HGT][MAX_DUNGEON_WID];
+
+/*
+ * The safety map must be rebuilt before it is next used
+ */
+bool safety_stale = true;
 
 /*
  * Array[DUNGEON_HGT][DUNGEON_WID] of cave grid flow "when" stamps
@@ -436,6 +460,45 @@ s16b alloc_race_size;
  */
 alloc_entry* alloc_race_table;
 
+/*
+ * Sets of candidates recently picked out of "alloc_kind_table", and the
+ * restriction set up by "get_obj_num_prep()"
+ */
+alloc_cache* alloc_kind_cache;
+u32b alloc_kind_prep;
+
+/*
+ * Sets of candidates recently picked out of "alloc_race_table", the
+ * restriction set up by "get_mon_num_prep()", and a stamp bumped whenever
+ * a race starts or stops being too prolific to appear
+ */
+alloc_cache* alloc_race_cache;
+u32b alloc_race_prep;
+u32b alloc_race_stamp;
+
+/*
+ * The size of "alloc_vault_table"
+ */
+s32b alloc_vault_size;
+
+/*
+ * The array[alloc_vault_size] of candidate vaults, as runs described by
+ * "alloc_vault_index", and the running total of their weights in each run
+ */
+s16b* alloc_vault_table;
+u32b* alloc_vault_total;
+
+/*
+ * The array[VAULT_INDEX_MAX] of runs in the "vault allocator table"
+ */
+vault_index* alloc_vault_index;
+
+/*
+ * The array[z_info->v_max] of vault layouts, and the grids they are made of
+ */
+vault_layout* vault_layouts;
+vault_op* vault_ops;
+
 /*
  * Specify attr/char pairs for visual special effects
  * Be sure to use "index & 0xFF" to avoid illegal access
@@ -815,6 +878,42 @@ char ghost_string[80];
  */
 char g_vault_name[80];
 
+/*
+ * Levels thrown away during generation, by reason, while generating the
+ * last level and since the game began, and how long the last level took
+ * (in milliseconds)
+ */
+u16b gen_fail_last[GEN_FAIL_MAX];
+u32b gen_fail_total[GEN_FAIL_MAX];
+u32b gen_msec;
+
+/*
+ * The rooms (by their centres) and vaults (by index into "v_info", and
+ * their centres) of the last level generated
+ */
+s16b gen_rooms;
+byte gen_room_y[DUN_ROOMS];
+byte gen_room_x[DUN_ROOMS];
+s16b gen_vault_n;
+s16b gen_vault_idx[GEN_VAULT_MAX];
+byte gen_vault_y[GEN_VAULT_MAX];
+byte gen_vault_x[GEN_VAULT_MAX];
+
+/*
+ * Where each level generated is written (see "gen_dump()"), and whether
+ * it is written as binary rather than text
+ */
+FILE* gen_dump_fff;
+bool gen_dump_binary;
+
+/*
+ * The last level generated, and a recorded level to generate next (if
+ * "gen_replay_set" is true)
+ */
+gen_record gen_last;
+gen_record gen_replay;
+bool gen_replay_set;
+
 /*
  * The "highscore" file descriptor, if available.
  */
@@ -1205,6 +1205,63 @@ static void do_cmd_wiz_jump(void)
     p_ptr->leaving = true;
 }
 
+/*
+ * Build a level again from its key (see "gen_key()"), by default the
+ * current one, to reproduce or time it
+ */
+static void do_cmd_wiz_replay(void)
+{
+    char tmp_val[80];
+
+    /* Default to the current level */
+    gen_key(tmp_val, sizeof(tmp_val), &gen_last);
+
+    /* Ask for a key */
+    if (!term_get_string("Level key: ", tmp_val, sizeof(tmp_val)))
+        return;
+
+    if (!gen_key_parse(tmp_val, &gen_replay))
+    {
+        msg_print("That is not a level key.");
+        return;
+    }
+
+    gen_replay_set = true;
+
+    // take back the current level's artefacts, unique forge and greater
+    // vault, so that building it again can place them again
+    unring_a_bell();
+
+    /* Leaving */
+    p_ptr->leaving = true;
+}
+
+/*
+ * Build a level from its key (see "gen_key()") without leaving the current
+ * one, to time it
+ */
+static void do_cmd_wiz_time_level(void)
+{
+    char tmp_val[80];
+    gen_record rec;
+
+    /* Default to the current level */
+    gen_key(tmp_val, sizeof(tmp_val), &gen_last);
+
+    /* Ask for a key */
+    if (!term_get_string("Level key: ", tmp_val, sizeof(tmp_val)))
+        return;
+
+    if (!gen_key_parse(tmp_val, &rec))
+    {
+        msg_print("That is not a level key.");
+        return;
+    }
+
+    if (!generate_aside(&rec))
+        msg_print("The current level was changed!");
+}
+
 /*
  * Tile test.
  */
@@ -1596,6 +1653,68 @@ static void do_cmd_wiz_zap(int d)
     }
 }
 
+/*
+ * Run the combat simulator against a range of monster races
+ *
+ * The results go to "combat-sim.txt" in the user directory.
+ */
+static void do_cmd_wiz_combat_sim(void)
+{
+    char buf[1024];
+    char tmp_val[80];
+    int r_min, r_max, fights;
+    bool archery;
+    long total;
+    FILE* fff;
+
+    /* Ask for the races (a single race, or 0 for all of them) */
+    my_strcpy(tmp_val, "0", sizeof(tmp_val));
+    if (!term_get_string("Monster race (0 for all): ", tmp_val, 5))
+        return;
+    r_min = atoi(tmp_val);
+    r_max = (r_min > 0) ? r_min : z_info->r_max - 1;
+
+    /* Ask for the number of fights per race */
+    my_strcpy(tmp_val, "1000", sizeof(tmp_val));
+    if (!term_get_string("Fights per race: ", tmp_val, 8))
+        return;
+    fights = atoi(tmp_val);
+    if (fights <= 0)
+        return;
+
+    archery = get_check("Use archery? ");
+
+    /* Build the filename */
+    path_build(buf, sizeof(buf), ANGBAND_DIR_USER, "combat-sim.txt");
+
+    /* File type is "TEXT" */
+    FILE_TYPE(FILE_TYPE_TEXT);
+
+    /* Open the file */
+    fff = my_fopen(buf, "w");
+
+    /* Oops */
+    if (!fff)
+    {
+        msg_print("Cannot create combat simulation file.");
+        return;
+    }
+
+    msg_print("Simulating...");
+    message_flush();
+
+    total = sim_combat(fff, r_min, r_max, fights, archery, seed_randart);
+
+    /* Check for errors */
+    if (ferror(fff) || my_fclose(fff))
+    {
+        msg_print("Cannot close combat simulation file.");
+        return;
+    }
+
+    msg_format("Simulated %ld fights (see combat-sim.txt).", total);
+}
+
 /*
  * Un-hide all monsters
  */
@@ -1828,6 +1947,13 @@ void do_cmd_debug(void)
         break;
     }
 
+    /* Battle simulator */
+    case 'B':
+    {
+        do_cmd_wiz_combat_sim();
+        break;
+    }
+
     /* Create any object */
     case 'c':
     {
@@ -1879,6 +2005,13 @@ void do_cmd_debug(void)
         break;
     }
 
+    /* Time a level from its key */
+    case 'G':
+    {
+        do_cmd_wiz_time_level();
+        break;
+    }
+
     /* Identify */
     case 'i':
     {
@@ -1893,6 +2026,13 @@ void do_cmd_debug(void)
         break;
     }
 
+    /* Build a level again from its key */
+    case 'L':
+    {
+        do_cmd_wiz_replay();
+        break;
+    }
+
     /* Self-Knowledge */
     case 'k':
     {
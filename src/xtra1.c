@@ -3240,7 +3240,7 @@ void update_stuff(void)
         return;
     }
 
-    log_debug("update_stuff: processing updates 0x%08X", p_ptr->update);
+    log_limited(LOG_DEBUG, 5, "update_stuff: processing updates 0x%08X", p_ptr->update);
 
     if (p_ptr->update & (PU_BONUS))
     {
@@ -3280,22 +3280,28 @@ void update_stuff(void)
     if (p_ptr->update & (PU_FORGET_VIEW))
     {
         p_ptr->update &= ~(PU_FORGET_VIEW);
-        log_debug("update_stuff: forgetting view");
+        log_limited(LOG_DEBUG, 5, "update_stuff: forgetting view");
         forget_view();
     }
 
     if (p_ptr->update & (PU_UPDATE_VIEW))
     {
-        p_ptr->update &= ~(PU_UPDATE_VIEW);
-        log_debug("update_stuff: updating view");
+        p_ptr->update &= ~(PU_UPDATE_VIEW | PU_UPDATE_LIGHT);
+        log_limited(LOG_DEBUG, 5, "update_stuff: updating view");
         update_view();
     }
 
+    if (p_ptr->update & (PU_UPDATE_LIGHT))
+    {
+        p_ptr->update &= ~(PU_UPDATE_LIGHT);
+        update_light();
+    }
+
     if (p_ptr->update & (PU_DISTANCE))
     {
         p_ptr->update &= ~(PU_DISTANCE);
         p_ptr->update &= ~(PU_MONSTERS);
-        log_debug("update_stuff: updating distances and monsters");
+        log_limited(LOG_DEBUG, 5, "update_stuff: updating distances and monsters");
         update_monsters(true);
     }
 
@@ -3347,6 +3353,11 @@ void redraw_stuff(void)
         prt_map();
     }
 
+    if (p_ptr->redraw & (PR_SPOTS))
+    {
+        prt_spots();
+    }
+
     if (p_ptr->redraw & (PR_BASIC))
     {
         p_ptr->redraw &= ~(PR_BASIC);
@@ -3533,7 +3544,7 @@ void window_stuff(void)
         return;
     }
 
-    log_debug("window_stuff: processing windows 0x%08X", p_ptr->window);
+    log_limited(LOG_DEBUG, 5, "window_stuff: processing windows 0x%08X", p_ptr->window);
 
     /* Scan windows */
     for (j = 0; j < ANGBAND_TERM_MAX; j++)
@@ -3605,6 +3616,41 @@ void window_stuff(void)
     log_trace("window_stuff: completed all window updates");
 }
 
+/*
+ * Handle "p_ptr->window" from the game loop, no more than "fresh_rate"
+ * times a second.
+ *
+ * While running or resting the monster list and friends are otherwise
+ * rebuilt after every game turn in which anything moved, so the time taken
+ * to show the map grows with every subwindow that is open.  Skipped windows
+ * stay flagged, and are drawn by "inkey()" before it waits for a key.
+ */
+void window_stuff_limited(void)
+{
+    static u32b window_last = 0;
+    u32b now;
+
+    if (!p_ptr->window)
+        return;
+
+    /* No limit */
+    if (fresh_rate <= 0)
+    {
+        window_stuff();
+        return;
+    }
+
+    now = clock_msec();
+
+    /* Too soon */
+    if ((now >= window_last) && (now - window_last < 1000L / fresh_rate))
+        return;
+
+    window_stuff();
+
+    window_last = now;
+}
+
 /*
  * Handle "p_ptr->update" and "p_ptr->redraw" and "p_ptr->window"
  */
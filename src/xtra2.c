@@ -2389,6 +2389,7 @@ void monster_death(int m_idx)
     if (r_ptr->flags1 & (RF1_UNIQUE))
     {
         r_ptr->max_num = 0;
+        alloc_race_stamp++;
     }
 
     /* Count kills this life */
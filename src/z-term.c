@@ -188,6 +188,7 @@
  *   Term->wipe_hook = Draw some blank spaces
  *   Term->text_hook = Draw some text in the window
  *   Term->pict_hook = Draw some attr/chars in the window
+ *   Term->span_hook = Draw some text in several attrs in the window
  *
  * The "Term->user_hook" hook provides a simple hook to an implementation
  * defined function, with application defined semantics.  It is available
@@ -234,6 +235,17 @@
  * the terrain values as a background and the "ap", "cp" values in
  * the foreground.
  *
+ * The "Term->span_hook" hook provides this package with a way to "draw",
+ * starting at "x,y", the "n" chars contained in "s", each using the attr
+ * at the same place in "ap".  Grids with a zero attr are to be erased as
+ * with "Term->wipe_hook" (unless the "always_text" flag is set).  It is an
+ * optional replacement for "Term->text_hook" and "Term->wipe_hook", used
+ * when neither the "always_pict" nor the "higher_pict" flag is set, for
+ * visual modules which can draw a whole changed stretch of a row at once
+ * more cheaply than one call per attr (such as over a slow connection).
+ * Short gaps of unchanged blanks are included in the stretch rather than
+ * skipped, since redrawing a few spaces is cheaper than moving the cursor.
+ *
  * The game "Angband" uses a set of files called "main-xxx.c", for
  * various "xxx" suffixes.  Most of these contain a function called
  * "init_xxx()", that will prepare the underlying visual system for
@@ -964,6 +976,98 @@ static void Term_fresh_row_text(int y, int x1, int x2)
     }
 }
 
+/*
+ * Flush a row of the current window (see "Term_fresh")
+ *
+ * Display text using "Term->span_hook", in as few calls as possible
+ */
+static void Term_fresh_row_span(int y, int x1, int x2)
+{
+    int x;
+
+    byte* old_aa = Term->old->a[y];
+    char* old_cc = Term->old->c[y];
+
+    byte* scr_aa = Term->scr->a[y];
+    char* scr_cc = Term->scr->c[y];
+
+    /* Pending length */
+    int fn = 0;
+
+    /* Pending start */
+    int fx = 0;
+
+    /* Unchanged blanks since the last changed grid */
+    int gap = 0;
+
+    byte oa;
+    char oc;
+
+    byte na;
+    char nc;
+
+    /* Scan "modified" columns */
+    for (x = x1; x <= x2; x++)
+    {
+        /* See what is currently here */
+        oa = old_aa[x];
+        oc = old_cc[x];
+
+        /* See what is desired there */
+        na = scr_aa[x];
+        nc = scr_cc[x];
+
+        /* Handle unchanged grids */
+        if ((na == oa) && (nc == oc))
+        {
+            /* Nothing pending */
+            if (!fn)
+                continue;
+
+            /* Hack -- bridge short stretches of blanks */
+            if ((nc == ' ') && (gap < TERM_SPAN_GAP))
+            {
+                gap++;
+                continue;
+            }
+
+            /* Draw the pending chars */
+            (void)((*Term->span_hook)(fx, y, fn, &scr_aa[fx], &scr_cc[fx]));
+
+            /* Forget */
+            fn = 0;
+            gap = 0;
+
+            /* Skip */
+            continue;
+        }
+
+        /* Save new contents */
+        old_aa[x] = na;
+        old_cc[x] = nc;
+
+        /* Extend the pending chars (over any bridged blanks) */
+        if (fn)
+        {
+            fn += gap + 1;
+            gap = 0;
+        }
+
+        /* Restart */
+        else
+        {
+            fx = x;
+            fn = 1;
+        }
+    }
+
+    /* Flush (leaving off any trailing blanks) */
+    if (fn)
+    {
+        (void)((*Term->span_hook)(fx, y, fn, &scr_aa[fx], &scr_cc[fx]));
+    }
+}
+
 /*
  * Actually perform all requested changes to the window
  *
@@ -1260,6 +1364,13 @@ errr Term_fresh(void)
                     Term_fresh_row_both(y, x1, x2);
                 }
 
+                /* Draw whole stretches of text at once */
+                else if (Term->span_hook)
+                {
+                    /* Flush the row */
+                    Term_fresh_row_span(y, x1, x2);
+                }
+
                 /* Never use "Term_pict()" */
                 else
                 {
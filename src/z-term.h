@@ -216,6 +216,8 @@ struct term
 
     errr (*pict_hook)(int x, int y, int n, const byte* ap, const char* cp,
         const byte* tap, const char* tcp);
+
+    errr (*span_hook)(int x, int y, int n, const byte* ap, cptr s);
 };
 
 /**** Available Constants ****/
@@ -251,6 +253,12 @@ struct term
 #define TERM_XTRA_LEVEL 12 /* Change the "soft" level (optional) */
 #define TERM_XTRA_DELAY 13 /* Delay some milliseconds (optional) */
 
+/*
+ * The longest run of unchanged blanks that "Term->span_hook" is asked to
+ * redraw rather than skip over
+ */
+#define TERM_SPAN_GAP 8
+
 #define MAX_COLORS 32 /* The number of usable colours */
 #define BG_BLACK 0 /* The set number for the black-background glyphs */
 #define BG_SAME 1 /* The set number for the same-background glyphs */